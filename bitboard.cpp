@@ -0,0 +1,5 @@
+#include "bitboard.h"
+
+// Initializing the static variable: three_in_a_row_table
+
+vector<char> bitboard::three_in_a_row_table = create_three_in_a_row_table();
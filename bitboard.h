@@ -0,0 +1,127 @@
+/* A "bitboard" is a whole 3x3 board packed into one unsigned int, for code that needs boards to be small and fast.
+
+    - Bit (row * 3 + col) is set if the computer ('C') has a piece on [row][col].
+    - Bit (9 + row * 3 + col) is set if the user ('U') has a piece on [row][col].
+
+   So the low 9 bits are the computer's pieces, and the next 9 bits are the user's pieces. Each of those 9-bit
+   masks can be looked up in a table to see if it has 3-in-a-row.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "position.h"
+
+using namespace std;
+
+class bitboard
+{
+public:
+    // Public static methods:
+    static unsigned int encode(const vector <vector<char>>& board); // packs board into a bitboard.
+    static vector <vector<char>> decode(unsigned int code); // unpacks a bitboard back into a board.
+    static unsigned int get_comp_pieces(unsigned int code); // returns the computer's 9-bit mask.
+    static unsigned int get_user_pieces(unsigned int code); // returns the user's 9-bit mask.
+    static unsigned int get_empty_squares(unsigned int code); // returns a 9-bit mask of the empty squares.
+    static int count_pieces(unsigned int code); // returns how many pieces are on the board (i.e., its depth).
+    static bool is_three_in_a_row(unsigned int pieces); // returns true if the 9-bit mask has a 3-in-a-row.
+
+    static vector<char> create_three_in_a_row_table(); // creates the table below, by asking position::three_in_a_row()
+                                                       // about every possible 9-bit mask.
+
+    // Public static variable(s):
+    static vector<char> three_in_a_row_table; // stores, for each 9-bit mask, 1 if it has a 3-in-a-row (else 0).
+};
+
+// The static variable is initialized in bitboard.cpp, so that this header can be included by more than one
+// translation unit.
+
+// PUBLIC STATIC METHODS:
+
+inline unsigned int bitboard::encode(const vector <vector<char>>& board)
+{
+    unsigned int code = 0;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (board[row][col] == 'C')
+            {
+                code |= 1u << (row * 3 + col);
+            }
+
+            else if (board[row][col] == 'U')
+            {
+                code |= 1u << (9 + row * 3 + col);
+            }
+        }
+    }
+
+    return code;
+}
+
+inline vector <vector<char>> bitboard::decode(unsigned int code)
+{
+    vector <vector<char>> board(3, vector<char>(3, ' '));
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (code & (1u << square))
+        {
+            board[square / 3][square % 3] = 'C';
+        }
+
+        else if (code & (1u << (9 + square)))
+        {
+            board[square / 3][square % 3] = 'U';
+        }
+    }
+
+    return board;
+}
+
+inline unsigned int bitboard::get_comp_pieces(unsigned int code)
+{
+    return code & 511;
+}
+
+inline unsigned int bitboard::get_user_pieces(unsigned int code)
+{
+    return (code >> 9) & 511;
+}
+
+inline unsigned int bitboard::get_empty_squares(unsigned int code)
+{
+    return ~(get_comp_pieces(code) | get_user_pieces(code)) & 511;
+}
+
+inline int bitboard::count_pieces(unsigned int code)
+{
+    int count = 0;
+
+    for (unsigned int rest = code; rest != 0; rest &= rest - 1) // each time through, the lowest set bit is removed.
+    {
+        count ++;
+    }
+
+    return count;
+}
+
+inline bool bitboard::is_three_in_a_row(unsigned int pieces)
+{
+    return three_in_a_row_table[pieces] == 1;
+}
+
+inline vector<char> bitboard::create_three_in_a_row_table()
+{
+    vector<char> table(512);
+
+    for (unsigned int pieces = 0; pieces < 512; pieces++)
+    {
+        table[pieces] = position::three_in_a_row(decode(pieces), 'C'); // decode() puts a 'C' on each set bit.
+    }
+
+    return table;
+}
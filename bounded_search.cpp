@@ -0,0 +1,5 @@
+#include "bounded_search.h"
+
+// Initializing the static variable: piece_keys
+
+vector<uint64_t> bounded_search::piece_keys = create_piece_keys();
@@ -0,0 +1,620 @@
+/* "bounded_search" is an alpha-beta search for mnk_boards that never uses more memory than it's given, for boards where
+   keeping the whole tree (like position does) or an ever-growing cache would eventually run out of memory.
+
+    - Nothing is kept between nodes except a transposition_table, whose size is fixed when the search is created
+      (the biggest power of two number of buckets that fits in the memory limit). Moves are kept in arrays on the stack.
+    - Each bucket of the table has two slots (two-tier replacement). The first slot only gives way to a result from an
+      equal or deeper search, so expensive results survive. The second slot is always replaced, so recent results
+      are never turned away.
+    - Iterative deepening, stopped by a search_budget (a deadline and/or a node budget). If the budget runs out in the
+      middle of a depth, the best move so far is still used, as long as the previous depth's best move (which is
+      always searched first) was finished. Otherwise, the last finished depth's move is used.
+    - Only squares within two squares of a piece are tried (or the middle square, on an empty board), since moves far
+      from everything else hardly ever matter.
+    - Scores are from the point of view of the side to move. A win is win_score minus the number of moves it takes.
+    - Before the main search, a threat_search looks for a win made only of threats (fours and threat moves), which it
+      finds far faster than the full search can. It gets a quarter of the node budget (or threat_pass_nodes, if the
+      budget has no node limit), and its nodes count towards the budget too.
+ */
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+
+#include "mnk_board.h"
+#include "search_budget.h"
+#include "memory_stats.h"
+#include "tracing.h"
+#include "threat_search.h"
+
+using namespace std;
+
+struct table_slot
+{
+    uint64_t key = 0;
+    int score = 0;
+    short best_move = -1;
+    signed char depth = -1; // -1 if the slot is empty.
+    signed char bound = 0; // 0 exact, 1 lower bound, 2 upper bound.
+};
+
+class transposition_table
+{
+public:
+    // Constructor:
+    transposition_table(size_t max_bytesP); // the table never takes more than max_bytesP bytes (at least 1 bucket).
+
+    // Public methods:
+    const table_slot* probe(uint64_t key) const; // returns the slot holding key, or nullptr if it isn't stored.
+    void store(uint64_t key, int score, int depth, int bound, int best_move);
+    void clear();
+
+    // Getters:
+    size_t get_size_in_bytes() const;
+    long long get_replacements() const; // how many times a slot holding a different position was written over.
+
+private:
+    struct bucket
+    {
+        table_slot deep; // depth-preferred.
+        table_slot recent; // always replaced.
+    };
+
+    vector<bucket> buckets;
+    long long replacements;
+};
+
+struct bounded_search_result
+{
+    int best_move = -1; // a square, or -1 if there are no moves.
+    int score = 0;
+    int depth = 0; // the deepest search that finished.
+    long long nodes = 0;
+    bool hit_budget = false; // true if the search stopped because the budget ran out.
+};
+
+class bounded_search
+{
+public:
+    static const int win_score = 1000000;
+    static const int threat_pass_threats = 10; // the most attacking moves in a win the threat_search looks for.
+    static const long long threat_pass_nodes = 200000;
+
+    // Constructor:
+    bounded_search(size_t memory_limitP); // memory_limitP is in bytes.
+
+    // Public methods:
+    bounded_search_result search(const mnk_board& boardP, bool comp_to_moveP, const search_budget& budget); // budget
+                                                                                                            // should
+                                                                                                            // have a
+                                                                                                            // limit.
+    const transposition_table& get_table() const;
+
+    // Public static methods:
+    static uint64_t get_piece_key(int square, bool is_comp); // a random number for each (square, side), which are
+                                                             // XORed together to make a board's key.
+
+private:
+    transposition_table table;
+    threat_search threats; // set up for the same size of board as board.
+    mnk_board board; // the board being searched, changed and changed back by make_move() and undo_move().
+    long long nodes;
+    const search_budget* budget;
+    bool out_of_budget;
+    vector <vector<int>> windows; // every k squares in a row on the board, for evaluate().
+
+    // Private methods:
+    int negamax(bool comp_to_move, uint64_t key, int depth, int alpha, int beta, int ply);
+    int generate_moves(int moves[], int table_move) const; // fills moves (in the order to try them), and returns how
+                                                           // many there are.
+    int evaluate(bool comp_to_move) const;
+    void create_windows();
+    bool is_budget_used_up();
+
+    // Private static variable(s):
+    static vector<uint64_t> piece_keys; // 2 for each of the mnk_board::max_squares squares.
+
+    // Private static methods:
+    static vector<uint64_t> create_piece_keys();
+};
+
+// The static variable is initialized in bounded_search.cpp, so that this header can be included by more than one
+// translation unit.
+
+// TRANSPOSITION_TABLE:
+
+inline transposition_table::transposition_table(size_t max_bytesP)
+{
+    size_t number_of_buckets = 1;
+
+    while (number_of_buckets * 2 * sizeof(bucket) <= max_bytesP)
+    {
+        number_of_buckets *= 2;
+    }
+
+    memory_scope scope(memory_cache);
+
+    buckets.resize(number_of_buckets);
+    replacements = 0;
+}
+
+inline const table_slot* transposition_table::probe(uint64_t key) const
+{
+    TRACE_SCOPE("table_probe");
+
+    const bucket& b = buckets[key & (buckets.size() - 1)];
+
+    if (b.deep.depth >= 0 && b.deep.key == key)
+    {
+        return &b.deep;
+    }
+
+    if (b.recent.depth >= 0 && b.recent.key == key)
+    {
+        return &b.recent;
+    }
+
+    return nullptr;
+}
+
+inline void transposition_table::store(uint64_t key, int score, int depth, int bound, int best_move)
+{
+    bucket& b = buckets[key & (buckets.size() - 1)];
+
+    table_slot slot;
+
+    slot.key = key;
+    slot.score = score;
+    slot.depth = depth;
+    slot.bound = bound;
+    slot.best_move = best_move;
+
+    // The deep slot takes it if it's empty, already holds this position, or holds a shallower result:
+
+    if (b.deep.depth < 0 || b.deep.key == key || depth >= b.deep.depth)
+    {
+        if (b.deep.depth >= 0 && b.deep.key != key)
+        {
+            replacements ++;
+            b.recent = b.deep; // the older result is kept around a bit longer.
+        }
+
+        b.deep = slot;
+        return;
+    }
+
+    if (b.recent.depth >= 0 && b.recent.key != key)
+    {
+        replacements ++;
+    }
+
+    b.recent = slot;
+}
+
+inline void transposition_table::clear()
+{
+    for (bucket& b: buckets)
+    {
+        b = bucket();
+    }
+
+    replacements = 0;
+}
+
+inline size_t transposition_table::get_size_in_bytes() const
+{
+    return buckets.size() * sizeof(bucket);
+}
+
+inline long long transposition_table::get_replacements() const
+{
+    return replacements;
+}
+
+// BOUNDED_SEARCH CONSTRUCTOR:
+
+inline bounded_search::bounded_search(size_t memory_limitP): table(memory_limitP), threats(mnk_board(1, 1, 1)), board(1, 1, 1)
+{
+    nodes = 0;
+    budget = nullptr;
+    out_of_budget = false;
+}
+
+// BOUNDED_SEARCH PUBLIC METHODS:
+
+inline bounded_search_result bounded_search::search(const mnk_board& boardP, bool comp_to_moveP, const search_budget& budgetP)
+{
+    bounded_search_result result;
+
+    bool same_shape = (board.get_rows() == boardP.get_rows() && board.get_cols() == boardP.get_cols() &&
+                       board.get_k() == boardP.get_k());
+
+    board = boardP;
+    nodes = 0;
+    budget = &budgetP;
+    out_of_budget = false;
+
+    if (!same_shape)
+    {
+        create_windows();
+        threats = threat_search(board);
+    }
+
+    // The first pass, for a quick forced win:
+
+    search_budget threat_budget = budgetP;
+
+    threat_budget.max_nodes = (budgetP.max_nodes != 0) ? budgetP.max_nodes / 4 : threat_pass_nodes;
+
+    threat_search_result threat = threats.find_forced_win(board, comp_to_moveP, threat_pass_threats, threat_budget);
+
+    nodes = threat.nodes;
+
+    if (threat.found)
+    {
+        result.best_move = threat.best_move;
+        result.score = win_score - threat.plies;
+        result.depth = threat.plies;
+        result.nodes = nodes;
+
+        return result;
+    }
+
+    uint64_t key = comp_to_moveP ? 1 : 0;
+
+    for (int square = 0; square < board.get_number_of_squares(); square++)
+    {
+        if (!board.is_empty(square))
+        {
+            key ^= get_piece_key(square, board.get_square(square) == 'C');
+        }
+    }
+
+    int moves[mnk_board::max_squares];
+    int count = generate_moves(moves, -1);
+
+    if (count == 0)
+    {
+        return result;
+    }
+
+    result.best_move = moves[0];
+
+    for (int depth = 1; depth <= board.get_number_of_squares() - board.get_number_of_pieces(); depth++)
+    {
+        int alpha = -win_score - 1;
+        int best = -1;
+        bool first_move_finished = false;
+
+        for (int i = 0; i < count; i++)
+        {
+            int score;
+
+            board.make_move(moves[i], comp_to_moveP);
+
+            if (board.is_win_at(moves[i]))
+            {
+                score = win_score - 1;
+            }
+
+            else
+            {
+                score = -negamax(!comp_to_moveP, key ^ 1 ^ get_piece_key(moves[i], comp_to_moveP), depth - 1,
+                                 -win_score - 1, -alpha, 1);
+            }
+
+            board.undo_move(moves[i]);
+
+            if (out_of_budget)
+            {
+                break;
+            }
+
+            first_move_finished = true;
+
+            if (score > alpha)
+            {
+                alpha = score;
+                best = i;
+            }
+        }
+
+        if (out_of_budget && !first_move_finished) // nothing from this depth can be trusted.
+        {
+            break;
+        }
+
+        // Either the depth finished, or at least the move that was best last time got a score this time (so anything
+        // that beat it is better):
+
+        result.best_move = moves[best];
+        result.score = alpha;
+
+        int temp = moves[best]; // search it first next time.
+        moves[best] = moves[0];
+        moves[0] = temp;
+
+        if (out_of_budget)
+        {
+            break;
+        }
+
+        result.depth = depth;
+
+        if (alpha >= win_score - board.get_number_of_squares() || alpha <= -win_score + board.get_number_of_squares())
+        {
+            break; // the game is decided, so searching deeper won't change anything.
+        }
+    }
+
+    result.nodes = nodes;
+    result.hit_budget = out_of_budget;
+
+    return result;
+}
+
+inline const transposition_table& bounded_search::get_table() const
+{
+    return table;
+}
+
+// BOUNDED_SEARCH PUBLIC STATIC METHODS:
+
+inline uint64_t bounded_search::get_piece_key(int square, bool is_comp)
+{
+    return piece_keys[square * 2 + is_comp];
+}
+
+// BOUNDED_SEARCH PRIVATE METHODS:
+
+inline int bounded_search::negamax(bool comp_to_move, uint64_t key, int depth, int alpha, int beta, int ply)
+{
+    nodes ++;
+
+    if (is_budget_used_up())
+    {
+        return 0;
+    }
+
+    if (board.is_full())
+    {
+        return 0;
+    }
+
+    if (depth <= 0)
+    {
+        return evaluate(comp_to_move);
+    }
+
+    const table_slot* slot = table.probe(key);
+    int table_move = -1;
+
+    if (slot != nullptr)
+    {
+        table_move = slot->best_move;
+
+        if (slot->depth >= depth &&
+            (slot->bound == 0 || (slot->bound == 1 && slot->score >= beta) || (slot->bound == 2 && slot->score <= alpha)))
+        {
+            return slot->score;
+        }
+    }
+
+    int moves[mnk_board::max_squares];
+    int count = generate_moves(moves, table_move);
+    int original_alpha = alpha;
+    int best_score = -win_score - 1;
+    int best_move = moves[0];
+
+    for (int i = 0; i < count; i++)
+    {
+        int score;
+
+        board.make_move(moves[i], comp_to_move);
+
+        if (board.is_win_at(moves[i]))
+        {
+            score = win_score - ply - 1;
+        }
+
+        else
+        {
+            score = -negamax(!comp_to_move, key ^ 1 ^ get_piece_key(moves[i], comp_to_move), depth - 1, -beta, -alpha,
+                             ply + 1);
+        }
+
+        board.undo_move(moves[i]);
+
+        if (out_of_budget)
+        {
+            return 0;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_move = moves[i];
+        }
+
+        if (score > alpha)
+        {
+            alpha = score;
+        }
+
+        if (alpha >= beta)
+        {
+            break;
+        }
+    }
+
+    table.store(key, best_score, depth, (best_score <= original_alpha) ? 2 : ((best_score >= beta) ? 1 : 0), best_move);
+
+    return best_score;
+}
+
+inline int bounded_search::generate_moves(int moves[], int table_move) const
+{
+    int rows = board.get_rows();
+    int cols = board.get_cols();
+    int count = 0;
+
+    if (board.get_number_of_pieces() == 0)
+    {
+        moves[0] = (rows / 2) * cols + cols / 2;
+        return 1;
+    }
+
+    if (table_move >= 0 && board.is_empty(table_move))
+    {
+        moves[count++] = table_move;
+    }
+
+    // Squares next to a piece come before squares two away from one:
+
+    for (int distance = 1; distance <= 2; distance++)
+    {
+        for (int square = 0; square < rows * cols; square++)
+        {
+            if (!board.is_empty(square) || square == table_move)
+            {
+                continue;
+            }
+
+            int row = square / cols;
+            int col = square % cols;
+            int nearest = 3; // the distance to the nearest piece, if it's 2 or less.
+
+            for (int r = max(0, row - 2); r <= min(rows - 1, row + 2) && nearest > 1; r++)
+            {
+                for (int c = max(0, col - 2); c <= min(cols - 1, col + 2); c++)
+                {
+                    if (!board.is_empty(r * cols + c))
+                    {
+                        nearest = min(nearest, max(abs(r - row), abs(c - col)));
+                    }
+                }
+            }
+
+            if (nearest == distance)
+            {
+                moves[count++] = square;
+            }
+        }
+    }
+
+    return count;
+}
+
+inline int bounded_search::evaluate(bool comp_to_move) const
+{
+    // Every window of k squares in a row that only one side has pieces in is worth more, the more pieces it has:
+
+    int score = 0;
+
+    for (const vector<int>& window: windows)
+    {
+        int comp_count = 0;
+        int user_count = 0;
+
+        for (int square: window)
+        {
+            char c = board.get_square(square);
+
+            comp_count += (c == 'C');
+            user_count += (c == 'U');
+        }
+
+        if (user_count == 0 && comp_count > 0)
+        {
+            score += 1 << (2 * min(comp_count, 8));
+        }
+
+        else if (comp_count == 0 && user_count > 0)
+        {
+            score -= 1 << (2 * min(user_count, 8));
+        }
+    }
+
+    score = max(-win_score / 2, min(win_score / 2, score)); // so it can never be mistaken for a win or loss.
+
+    return comp_to_move ? score : -score;
+}
+
+inline void bounded_search::create_windows()
+{
+    const int steps[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+    int rows = board.get_rows();
+    int cols = board.get_cols();
+    int k = board.get_k();
+
+    windows.clear();
+
+    for (int square = 0; square < rows * cols; square++)
+    {
+        for (const auto& step: steps)
+        {
+            int end_row = square / cols + (k - 1) * step[0];
+            int end_col = square % cols + (k - 1) * step[1];
+
+            if (end_row < 0 || end_row >= rows || end_col < 0 || end_col >= cols)
+            {
+                continue;
+            }
+
+            vector<int> window;
+
+            for (int i = 0; i < k; i++)
+            {
+                window.push_back((square / cols + i * step[0]) * cols + square % cols + i * step[1]);
+            }
+
+            windows.push_back(window);
+        }
+    }
+}
+
+inline bool bounded_search::is_budget_used_up()
+{
+    if (budget->max_nodes != 0 && nodes >= budget->max_nodes)
+    {
+        out_of_budget = true;
+    }
+
+    // Reading the clock costs more than counting nodes, so it's only done every 1024 nodes:
+
+    if (!out_of_budget && (nodes & 1023) == 0 && chrono::steady_clock::now() >= budget->deadline)
+    {
+        out_of_budget = true;
+    }
+
+    return out_of_budget;
+}
+
+inline vector<uint64_t> bounded_search::create_piece_keys()
+{
+    vector<uint64_t> keys(mnk_board::max_squares * 2);
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    for (uint64_t& key: keys)
+    {
+        // splitmix64, so the keys are the same every run:
+
+        state += 0x9E3779B97F4A7C15ULL;
+
+        uint64_t z = state;
+
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+        key = (z ^ (z >> 31)) & ~uint64_t(1); // bit 0 is kept for whose turn it is.
+    }
+
+    return keys;
+}
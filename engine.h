@@ -0,0 +1,353 @@
+/* The "engine" is the non-blocking way to ask the computer for a move.
+
+    - A caller fills in a search_request (board, whose turn, depth, a budget, a cancellation_token, and optionally a
+      function to receive progress updates), and submits it.
+    - submit() returns right away. The search runs on a worker_pool, and the result arrives through a future (or a
+      callback, if the caller gave one).
+    - The search can be stopped early by cancelling the token, or by the budget's deadline passing. Either way, the
+      result holds the best move among the moves searched so far.
+
+   Each move for the side to play is searched on its own, with a full alpha-beta window (so its evaluation is exact), and
+   a progress update goes out after each one. The search always goes to the end of the game, so the depth in a
+   progress update is simply the number of moves left to play. (For the same reason, the budget's max_nodes isn't used.)
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "position.h"
+#include "worker_pool.h"
+#include "search_budget.h"
+
+using namespace std;
+
+class cancellation_token
+{
+public:
+    // Constructor:
+    cancellation_token(); // starts off not cancelled.
+
+    // Public methods:
+    void cancel(); // asks every search using this token (or a copy of it) to stop as soon as possible.
+    bool is_cancelled() const;
+    const atomic<bool>* get_flag() const; // the flag itself, to be used as position::stop_signal.
+
+private:
+    shared_ptr<atomic<bool>> flag; // shared between all copies of the token.
+};
+
+struct search_progress
+{
+    coordinate best_move; // best move found so far.
+    int best_evaluation; // evaluation of the position after best_move.
+    int depth; // how many moves deep the search goes (always to the end of the game).
+    int moves_searched; // how many moves for the side to play have been searched so far.
+    int moves_total; // how many moves the side to play has.
+};
+
+struct search_result
+{
+    bool completed = false; // stores true if every move was searched.
+    bool cancelled = false; // stores true if the token was cancelled before the search finished.
+    bool timed_out = false; // stores true if the deadline passed before the search finished.
+    coordinate best_move = {-1, -1}; // {-1, -1} if the game is already over or no move was searched in time.
+    int evaluation = 100000; // evaluation of the position after best_move (100000 if there's no best_move).
+    int moves_searched = 0;
+    int moves_total = 0;
+};
+
+struct search_request
+{
+    vector <vector<char>> board; // the position to search, with 'C', 'U' and ' ' like position's board.
+    bool is_comp_turn = true;
+    int depth = 0; // number of pieces on board.
+    search_budget budget;
+    cancellation_token token;
+    function<void(const search_progress&)> on_progress; // optional. Called on a worker thread after each move searched.
+};
+
+class engine
+{
+public:
+    // Constructors & destructor:
+    engine(); // runs searches on worker_pool::shared().
+    engine(worker_pool& poolP); // runs searches on poolP, which has to outlive the engine.
+    ~engine(); // waits for every search already submitted to finish.
+
+    // Public methods:
+    future<search_result> submit(search_request request);
+    void submit(search_request request, function<void(const search_result&)> on_done); // on_done is called on a
+                                                                                       // worker thread.
+
+    // Public static methods:
+    static search_result search(const search_request& request); // the search itself, run on the calling thread.
+
+private:
+    worker_pool& pool;
+
+    // The deadline watcher is a thread that cancels a search's token once its deadline passes:
+    thread deadline_watcher;
+    mutex deadlines_mutex; // guards deadlines, searches_running and shutting_down.
+    condition_variable deadlines_changed;
+    multimap <chrono::steady_clock::time_point, cancellation_token> deadlines; // searches that have a deadline.
+    int searches_running; // stores how many submitted searches haven't finished yet.
+    bool shutting_down;
+
+    // Private methods:
+    void run(const search_request& request, function<void(const search_result&)> on_done); // runs on the pool.
+    void watch_deadlines(); // what deadline_watcher runs.
+};
+
+// CANCELLATION_TOKEN:
+
+inline cancellation_token::cancellation_token()
+{
+    flag = make_shared<atomic<bool>>(false);
+}
+
+inline void cancellation_token::cancel()
+{
+    *flag = true;
+}
+
+inline bool cancellation_token::is_cancelled() const
+{
+    return *flag;
+}
+
+inline const atomic<bool>* cancellation_token::get_flag() const
+{
+    return flag.get();
+}
+
+// CONSTRUCTORS & DESTRUCTOR:
+
+inline engine::engine() : engine(worker_pool::shared())
+{
+}
+
+inline engine::engine(worker_pool& poolP) : pool(poolP)
+{
+    searches_running = 0;
+    shutting_down = false;
+
+    deadline_watcher = thread(&engine::watch_deadlines, this);
+}
+
+inline engine::~engine()
+{
+    {
+        unique_lock<mutex> lock(deadlines_mutex);
+
+        deadlines_changed.wait(lock, [this] { return searches_running == 0; });
+
+        shutting_down = true;
+    }
+
+    deadlines_changed.notify_all();
+
+    deadline_watcher.join();
+}
+
+// PUBLIC METHODS:
+
+inline future<search_result> engine::submit(search_request request)
+{
+    shared_ptr<promise<search_result>> result = make_shared<promise<search_result>>();
+
+    submit(move(request), [result](const search_result& r) { result->set_value(r); });
+
+    return result->get_future();
+}
+
+inline void engine::submit(search_request request, function<void(const search_result&)> on_done)
+{
+    {
+        lock_guard<mutex> lock(deadlines_mutex);
+
+        searches_running ++;
+
+        if (request.budget.deadline != chrono::steady_clock::time_point::max())
+        {
+            deadlines.insert(make_pair(request.budget.deadline, request.token));
+        }
+    }
+
+    deadlines_changed.notify_all(); // the watcher may need to wake up sooner now.
+
+    shared_ptr<search_request> shared_request = make_shared<search_request>(move(request));
+
+    pool.submit([this, shared_request, on_done] { run(*shared_request, on_done); });
+}
+
+// PUBLIC STATIC METHODS:
+
+inline search_result engine::search(const search_request& request)
+{
+    search_result result;
+
+    const vector <vector<char>>& board = request.board;
+
+    // If someone has already won, there's nothing to search:
+
+    if (position::three_in_a_row(board, 'C') || position::three_in_a_row(board, 'U'))
+    {
+        result.completed = true;
+        return result;
+    }
+
+    for (const coordinate& temp: position::coordinates)
+    {
+        if (board[temp.row][temp.col] == ' ')
+        {
+            result.moves_total ++;
+        }
+    }
+
+    const atomic<bool>* previous_stop_signal = position::stop_signal;
+
+    position::stop_signal = request.token.get_flag();
+
+    for (const coordinate& temp: position::coordinates)
+    {
+        if (board[temp.row][temp.col] != ' ')
+        {
+            continue;
+        }
+
+        if (request.token.is_cancelled())
+        {
+            break;
+        }
+
+        vector <vector<char>> copy_board = board;
+
+        if (request.is_comp_turn)
+        {
+            copy_board[temp.row][temp.col] = 'C';
+        }
+
+        else
+        {
+            copy_board[temp.row][temp.col] = 'U';
+        }
+
+        // Lazy, so the search doesn't keep its tree around after the evaluation is known:
+
+        position future(copy_board, !request.is_comp_turn, request.depth + 1, 100000, 100000, true);
+
+        if (request.token.is_cancelled()) // the search of future was cut off, so its evaluation means nothing.
+        {
+            break;
+        }
+
+        int future_evaluation = future.get_evaluation();
+
+        result.moves_searched ++;
+
+        // The computer wants the highest evaluation, and the user wants the lowest:
+
+        if (result.evaluation == 100000 ||
+            (request.is_comp_turn && future_evaluation > result.evaluation) ||
+            (!request.is_comp_turn && future_evaluation < result.evaluation))
+        {
+            result.evaluation = future_evaluation;
+            result.best_move = temp;
+        }
+
+        if (request.on_progress)
+        {
+            search_progress progress;
+
+            progress.best_move = result.best_move;
+            progress.best_evaluation = result.evaluation;
+            progress.depth = 9 - request.depth;
+            progress.moves_searched = result.moves_searched;
+            progress.moves_total = result.moves_total;
+
+            request.on_progress(progress);
+        }
+    }
+
+    position::stop_signal = previous_stop_signal;
+
+    result.completed = (result.moves_searched == result.moves_total);
+
+    if (!result.completed)
+    {
+        // The watcher cancels the token when the deadline passes, so check the clock to tell the two apart:
+
+        result.timed_out = (chrono::steady_clock::now() >= request.budget.deadline);
+        result.cancelled = !result.timed_out;
+    }
+
+    return result;
+}
+
+// PRIVATE METHODS:
+
+inline void engine::run(const search_request& request, function<void(const search_result&)> on_done)
+{
+    search_result result = search(request);
+
+    {
+        lock_guard<mutex> lock(deadlines_mutex);
+
+        // This search is done, so its deadline doesn't need watching anymore:
+
+        for (auto it = deadlines.begin(); it != deadlines.end(); it++)
+        {
+            if (it->second.get_flag() == request.token.get_flag())
+            {
+                deadlines.erase(it);
+                break;
+            }
+        }
+    }
+
+    on_done(result);
+
+    lock_guard<mutex> lock(deadlines_mutex);
+
+    searches_running --;
+
+    deadlines_changed.notify_all(); // the destructor may be waiting for searches_running to reach 0. Notified while
+                                    // still holding the lock, so the engine can't be destroyed in the middle of this.
+}
+
+inline void engine::watch_deadlines()
+{
+    unique_lock<mutex> lock(deadlines_mutex);
+
+    while (!shutting_down)
+    {
+        if (deadlines.empty())
+        {
+            deadlines_changed.wait(lock);
+            continue;
+        }
+
+        chrono::steady_clock::time_point earliest = deadlines.begin()->first;
+
+        if (chrono::steady_clock::now() >= earliest)
+        {
+            deadlines.begin()->second.cancel();
+            deadlines.erase(deadlines.begin());
+        }
+
+        else
+        {
+            deadlines_changed.wait_until(lock, earliest);
+        }
+    }
+}
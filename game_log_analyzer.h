@@ -0,0 +1,367 @@
+/* A "game_log_analyzer" reads recorded games, replays them, and checks every move against perfect play.
+
+    - Each line of the log is one game: its moves in order, separated by spaces, in the same format that
+      position::is_valid_move() takes (e.g. "b2 a1 c3"). The first move is the first player's, and they alternate.
+    - A move is a blunder if it makes the result worse for the player who played it (e.g. from a win to a draw, or a
+      draw to a loss). A line with an unreadable move, a move onto a taken square, or a move after the game was already
+      over is reported as invalid, at the move where it went wrong.
+    - Each game gets one line in the report, in the same order as the log, and then totals for all games come at the end.
+
+   The work is split up into a pipeline, so every core is kept busy:
+    - The calling thread reads the log, and hands the lines out in batches to the worker_pool.
+    - Each batch is analyzed (and its report lines written into a string) on one of the pool's threads.
+    - The calling thread also writes the finished batches out, in the order they were read. Only a few batches are
+      allowed to be unwritten at once, so memory use stays the same no matter how long the log is.
+   Perfect play comes from a table of every reachable position's result, built once in the constructor and then only
+   read, so the pool's threads never have to wait for each other.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <istream>
+#include <ostream>
+
+#include "position.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+struct blunder
+{
+    int move_number; // 1 for the first move of the game.
+    coordinate square;
+    int result_before; // for the player who moved: 1 for a win with perfect play, 0 for a draw, -1 for a loss.
+    int result_after;
+};
+
+struct game_analysis
+{
+    long long game_number = 0; // 1 for the first line of the log.
+    int number_of_moves = 0;
+    int result = 0; // 1 if the first player won, 2 if the second player won, 3 for a draw, 0 if it isn't over.
+    int invalid_move_number = 0; // 0 if every move was fine.
+    vector<blunder> blunders;
+};
+
+struct analysis_totals
+{
+    long long games = 0;
+    long long invalid_games = 0;
+    long long moves = 0;
+    long long blunders = 0;
+    long long games_with_blunders = 0;
+    long long first_player_wins = 0;
+    long long second_player_wins = 0;
+    long long draws = 0;
+    long long unfinished = 0;
+};
+
+class game_log_analyzer
+{
+public:
+    // Constructor:
+    game_log_analyzer(worker_pool& poolP = worker_pool::shared(), int batch_sizeP = 4096);
+
+    // Public methods:
+    game_analysis analyze_game(const string& line, long long game_number) const;
+    analysis_totals run(istream& in, ostream& out); // analyzes every game in in, and writes the report to out.
+
+    // Public static methods:
+    static void write_game(ostream& out, const game_analysis& game);
+    static void write_totals(ostream& out, const analysis_totals& totals);
+
+private:
+    struct batch
+    {
+        vector<string> lines;
+        long long first_game_number;
+        string report; // filled in by the pool.
+        analysis_totals totals; // filled in by the pool.
+    };
+
+    worker_pool& pool;
+    int batch_size;
+    vector<signed char> results; // indexed by a bitboard with the first player's pieces as 'C': the first player's
+                                 // result with perfect play from there (1, 0 or -1).
+
+    mutex batches_mutex; // guards finished_batches.
+    condition_variable batch_finished;
+    map<long long, batch> finished_batches; // by the order they were read in, until they're written.
+
+    // Private methods:
+    void analyze_batch(batch& b) const;
+
+    // Private static methods:
+    static void add_totals(analysis_totals& total, const analysis_totals& more);
+    static void add_to_totals(analysis_totals& totals, const game_analysis& game);
+};
+
+// CONSTRUCTOR:
+
+inline game_log_analyzer::game_log_analyzer(worker_pool& poolP, int batch_sizeP): pool(poolP)
+{
+    batch_size = (batch_sizeP < 1) ? 1 : batch_sizeP;
+
+    memory_scope scope(memory_cache);
+
+    results.assign(1 << 18, 0);
+
+    // Every board where the first player has as many pieces as the second player, or one more. Some of these can't
+    // come up in a real game, but they're cheap, and the ones that can are all covered:
+
+    variant_solver<standard_rules> solver;
+
+    for (unsigned int code = 0; code < (1u << 18); code++)
+    {
+        int first_player_pieces = bitboard::count_pieces(bitboard::get_comp_pieces(code));
+        int second_player_pieces = bitboard::count_pieces(bitboard::get_user_pieces(code));
+
+        if ((bitboard::get_comp_pieces(code) & bitboard::get_user_pieces(code)) != 0 ||
+            first_player_pieces - second_player_pieces < 0 || first_player_pieces - second_player_pieces > 1)
+        {
+            continue;
+        }
+
+        standard_rules::state s;
+
+        s.code = code;
+        s.comp_to_move = (first_player_pieces == second_player_pieces); // the first player's pieces are the 'C' ones.
+
+        bool game_over;
+        int value = standard_rules::get_value(s, game_over);
+
+        if (!game_over)
+        {
+            value = solver.solve(s);
+        }
+
+        results[code] = s.comp_to_move ? value : -value;
+    }
+}
+
+// PUBLIC METHODS:
+
+inline game_analysis game_log_analyzer::analyze_game(const string& line, long long game_number) const
+{
+    game_analysis game;
+
+    game.game_number = game_number;
+
+    istringstream moves(line);
+    string text;
+    unsigned int code = 0;
+
+    while (moves >> text)
+    {
+        game.number_of_moves ++;
+
+        coordinate square;
+
+        if (game.result != 0 || !position::parse_coordinates(text, square) ||
+            (bitboard::get_empty_squares(code) & (1u << (square.row * 3 + square.col))) == 0)
+        {
+            game.invalid_move_number = game.number_of_moves;
+            return game;
+        }
+
+        bool first_player_moving = (game.number_of_moves % 2 == 1);
+        int bit = square.row * 3 + square.col;
+
+        // Results are kept for the first player, so flip them for the second player:
+
+        int sign = first_player_moving ? 1 : -1;
+        int result_before = sign * results[code];
+
+        code |= 1u << (first_player_moving ? bit : 9 + bit);
+
+        int result_after = sign * results[code];
+
+        if (result_after < result_before)
+        {
+            game.blunders.push_back({game.number_of_moves, square, result_before, result_after});
+        }
+
+        if (bitboard::is_three_in_a_row(first_player_moving ? bitboard::get_comp_pieces(code) :
+                                                              bitboard::get_user_pieces(code)))
+        {
+            game.result = first_player_moving ? 1 : 2;
+        }
+
+        else if (bitboard::get_empty_squares(code) == 0)
+        {
+            game.result = 3;
+        }
+    }
+
+    return game;
+}
+
+inline analysis_totals game_log_analyzer::run(istream& in, ostream& out)
+{
+    analysis_totals totals;
+
+    long long batches_read = 0;
+    long long batches_written = 0;
+    long long games_read = 0;
+    int max_unwritten = 2 * pool.get_number_of_threads() + 2; // enough to keep every thread busy while some wait.
+
+    bool end_of_log = false;
+
+    while (!end_of_log || batches_written < batches_read)
+    {
+        // Read (and hand out) the next batch, unless too many are still waiting to be written:
+
+        if (!end_of_log && batches_read - batches_written < max_unwritten)
+        {
+            batch next;
+            string line;
+
+            next.first_game_number = games_read + 1;
+
+            while (static_cast<int>(next.lines.size()) < batch_size && getline(in, line))
+            {
+                next.lines.push_back(line);
+            }
+
+            games_read += next.lines.size();
+            end_of_log = (static_cast<int>(next.lines.size()) < batch_size);
+
+            if (!next.lines.empty())
+            {
+                long long id = batches_read++;
+
+                // The batch moves over to the pool's thread, which hands it back once it's finished:
+
+                pool.submit([this, id, next = move(next)]() mutable
+                {
+                    analyze_batch(next);
+
+                    lock_guard<mutex> lock(batches_mutex);
+
+                    finished_batches[id] = move(next);
+                    batch_finished.notify_all();
+                });
+            }
+
+            continue;
+        }
+
+        // Write the next batch, in order, waiting for it if it isn't finished yet:
+
+        batch done;
+
+        {
+            unique_lock<mutex> lock(batches_mutex);
+
+            batch_finished.wait(lock, [&]() { return finished_batches.count(batches_written) != 0; });
+
+            done = move(finished_batches[batches_written]);
+            finished_batches.erase(batches_written);
+        }
+
+        out << done.report;
+
+        add_totals(totals, done.totals);
+
+        batches_written ++;
+    }
+
+    write_totals(out, totals);
+
+    return totals;
+}
+
+// PUBLIC STATIC METHODS:
+
+inline void game_log_analyzer::write_game(ostream& out, const game_analysis& game)
+{
+    const char* result_names[4] = {"unfinished", "first player won", "second player won", "draw"};
+    const char* value_names[3] = {"loss", "draw", "win"};
+
+    out << "Game " << game.game_number << ": " << game.number_of_moves << " moves, ";
+
+    if (game.invalid_move_number != 0)
+    {
+        out << "invalid at move " << game.invalid_move_number << "\n";
+        return;
+    }
+
+    out << result_names[game.result] << ", " << game.blunders.size() << " blunder(s)";
+
+    for (const blunder& b: game.blunders)
+    {
+        out << "; move " << b.move_number << " (" << char('a' + b.square.col) << (b.square.row + 1) << ") "
+            << value_names[b.result_before + 1] << " -> " << value_names[b.result_after + 1];
+    }
+
+    out << "\n";
+}
+
+inline void game_log_analyzer::write_totals(ostream& out, const analysis_totals& totals)
+{
+    out << "Games: " << totals.games << " (" << totals.invalid_games << " invalid)\n";
+    out << "Moves: " << totals.moves << ", blunders: " << totals.blunders << " (in " << totals.games_with_blunders
+        << " games)\n";
+    out << "Results: " << totals.first_player_wins << " first player wins, " << totals.second_player_wins
+        << " second player wins, " << totals.draws << " draws, " << totals.unfinished << " unfinished\n";
+}
+
+// PRIVATE METHODS:
+
+inline void game_log_analyzer::analyze_batch(batch& b) const
+{
+    ostringstream report;
+
+    for (size_t i = 0; i < b.lines.size(); i++)
+    {
+        game_analysis game = analyze_game(b.lines[i], b.first_game_number + i);
+
+        write_game(report, game);
+        add_to_totals(b.totals, game);
+    }
+
+    b.report = report.str();
+    b.lines.clear();
+}
+
+// PRIVATE STATIC METHODS:
+
+inline void game_log_analyzer::add_totals(analysis_totals& total, const analysis_totals& more)
+{
+    total.games += more.games;
+    total.invalid_games += more.invalid_games;
+    total.moves += more.moves;
+    total.blunders += more.blunders;
+    total.games_with_blunders += more.games_with_blunders;
+    total.first_player_wins += more.first_player_wins;
+    total.second_player_wins += more.second_player_wins;
+    total.draws += more.draws;
+    total.unfinished += more.unfinished;
+}
+
+inline void game_log_analyzer::add_to_totals(analysis_totals& totals, const game_analysis& game)
+{
+    totals.games ++;
+
+    if (game.invalid_move_number != 0)
+    {
+        totals.invalid_games ++;
+        return;
+    }
+
+    totals.moves += game.number_of_moves;
+    totals.blunders += game.blunders.size();
+    totals.games_with_blunders += !game.blunders.empty();
+    totals.first_player_wins += (game.result == 1);
+    totals.second_player_wins += (game.result == 2);
+    totals.draws += (game.result == 3);
+    totals.unfinished += (game.result == 0);
+}
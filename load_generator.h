@@ -0,0 +1,464 @@
+/* A "load_generator" pretends to be lots of people playing against the engine at once, and measures how the engine
+   holds up: how long each computer move takes, how many games finish per second, and how much CPU time each game costs.
+
+    - Each simulated player plays games the same way play_game() does: start a game, then alternate moves until it's
+      over, then start the next one. The player's own moves are random (legal) moves, made after a random think time
+      (anywhere from 0 to twice the average). The computer's moves are search_requests submitted to an engine.
+    - Players don't get a thread each. One scheduler thread wakes each player up when its think time is over, and the
+      computer's replies arrive through the engine's callbacks, so thousands of players cost almost nothing themselves.
+    - A computer move's latency is the time from submitting it to its result arriving. Latencies go into a
+      latency_histogram, whose buckets are at most about 6% wide, so percentiles come out within about 6%.
+    - CPU time is the whole process's (clock()), so nothing else should be running in the process at the time.
+ */
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <ostream>
+
+#include "position.h"
+#include "engine.h"
+
+using namespace std;
+
+class latency_histogram
+{
+public:
+    // Constructor:
+    latency_histogram();
+
+    // Public methods:
+    void record(long long microseconds); // can be called from any thread.
+    long long get_percentile(double p) const; // e.g. p = 0.99. Returns the top of the bucket the percentile falls in.
+    long long get_count() const;
+    long long get_max() const;
+    double get_mean() const;
+
+private:
+    static const int sub_buckets = 16; // buckets per power of two.
+
+    vector <atomic<long long>> counts;
+    atomic<long long> total_count;
+    atomic<long long> total_microseconds;
+    atomic<long long> max_microseconds;
+
+    // Private static methods:
+    static int get_bucket(long long microseconds);
+    static long long get_bucket_top(int bucket); // the biggest value that goes in bucket.
+};
+
+struct load_settings
+{
+    int players = 1000;
+    int games_per_player = 1;
+    int average_think_milliseconds = 500;
+    double comp_first_fraction = 0.5; // how many games the computer starts (like choosing who goes first in play_game()).
+    int move_deadline_milliseconds = 0; // 0 means no deadline.
+    unsigned long long seed = 1;
+};
+
+struct load_report
+{
+    long long games = 0;
+    long long comp_moves = 0;
+    long long user_moves = 0;
+    long long timed_out_moves = 0; // computer moves that hit the deadline before any move was searched.
+    double wall_seconds = 0;
+    double cpu_seconds = 0;
+    double games_per_second = 0;
+    double comp_moves_per_second = 0;
+    double cpu_milliseconds_per_game = 0;
+    long long p50_microseconds = 0;
+    long long p99_microseconds = 0;
+    long long p999_microseconds = 0;
+    long long max_microseconds = 0;
+    double mean_microseconds = 0;
+};
+
+class load_generator
+{
+public:
+    // Constructor:
+    load_generator(engine& engineP, const load_settings& settingsP);
+
+    // Public methods:
+    load_report run(); // plays every game, and returns once they've all finished.
+    const latency_histogram& get_histogram() const;
+
+    // Public static methods:
+    static void print_report(ostream& out, const load_report& report);
+
+private:
+    struct player
+    {
+        vector <vector<char>> board;
+        bool is_comp_turn;
+        int depth; // number of pieces on board.
+        int games_left;
+        chrono::steady_clock::time_point move_submitted; // when the last computer move was submitted.
+    };
+
+    struct wake_up
+    {
+        chrono::steady_clock::time_point when;
+        int player_number;
+
+        bool operator>(const wake_up& other) const { return when > other.when; }
+    };
+
+    engine& eng;
+    load_settings settings;
+    vector<player> players;
+    latency_histogram histogram;
+
+    mutex players_mutex; // guards everything below, and every player.
+    condition_variable changed;
+    priority_queue <wake_up, vector<wake_up>, greater<wake_up>> wake_ups; // players thinking, earliest first.
+    int players_finished;
+    long long games_finished;
+    long long comp_moves;
+    long long user_moves;
+    long long timed_out_moves;
+    unsigned long long random_state;
+
+    // Private methods (all called with players_mutex held):
+    void start_game(int player_number);
+    void next_turn(int player_number); // after a move: finish the game, or ask the engine, or start thinking.
+    void play_user_move(int player_number);
+    void on_comp_move(int player_number, const search_result& result); // called from the engine's callback.
+    void play_random_move(player& p); // plays a random empty square for whoever's turn it is.
+    unsigned long long next_random(); // xorshift.
+};
+
+// LATENCY_HISTOGRAM:
+
+inline latency_histogram::latency_histogram(): counts(64 * sub_buckets)
+{
+    total_count = 0;
+    total_microseconds = 0;
+    max_microseconds = 0;
+}
+
+inline void latency_histogram::record(long long microseconds)
+{
+    if (microseconds < 0)
+    {
+        microseconds = 0;
+    }
+
+    counts[get_bucket(microseconds)] ++;
+    total_count ++;
+    total_microseconds += microseconds;
+
+    long long current = max_microseconds;
+
+    while (microseconds > current && !max_microseconds.compare_exchange_weak(current, microseconds))
+    {
+        // compare_exchange_weak put the latest max into current, so just try again.
+    }
+}
+
+inline long long latency_histogram::get_percentile(double p) const
+{
+    long long wanted = (long long)(p * total_count + 0.5); // how many values have to be at or below the answer.
+    long long seen = 0;
+
+    if (wanted < 1)
+    {
+        wanted = 1;
+    }
+
+    for (size_t bucket = 0; bucket < counts.size(); bucket++)
+    {
+        seen += counts[bucket];
+
+        if (seen >= wanted)
+        {
+            return min(get_bucket_top(bucket), get_max());
+        }
+    }
+
+    return get_max();
+}
+
+inline long long latency_histogram::get_count() const
+{
+    return total_count;
+}
+
+inline long long latency_histogram::get_max() const
+{
+    return max_microseconds;
+}
+
+inline double latency_histogram::get_mean() const
+{
+    return (total_count == 0) ? 0 : double(total_microseconds) / total_count;
+}
+
+inline int latency_histogram::get_bucket(long long microseconds)
+{
+    // Values below sub_buckets get a bucket each. After that, each power of two is split into sub_buckets buckets:
+
+    if (microseconds < sub_buckets)
+    {
+        return microseconds;
+    }
+
+    int power = 63 - __builtin_clzll(microseconds); // microseconds is between 2^power and 2^(power + 1).
+    int sub_bucket = (microseconds >> (power - 4)) & (sub_buckets - 1); // the 4 bits after the top one.
+
+    return (power - 3) * sub_buckets + sub_bucket;
+}
+
+inline long long latency_histogram::get_bucket_top(int bucket)
+{
+    if (bucket < sub_buckets)
+    {
+        return bucket;
+    }
+
+    int power = bucket / sub_buckets + 3;
+    long long sub_bucket = bucket % sub_buckets;
+
+    return ((sub_buckets + sub_bucket + 1) << (power - 4)) - 1;
+}
+
+// LOAD_GENERATOR CONSTRUCTOR:
+
+inline load_generator::load_generator(engine& engineP, const load_settings& settingsP): eng(engineP)
+{
+    settings = settingsP;
+    players_finished = 0;
+    games_finished = 0;
+    comp_moves = 0;
+    user_moves = 0;
+    timed_out_moves = 0;
+    random_state = settings.seed * 2654435761ULL + 88172645463325252ULL; // xorshift can't start from 0.
+}
+
+// LOAD_GENERATOR PUBLIC METHODS:
+
+inline load_report load_generator::run()
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    clock_t cpu_start = clock();
+
+    {
+        lock_guard<mutex> lock(players_mutex);
+
+        players.assign(settings.players, player());
+
+        for (int i = 0; i < settings.players; i++)
+        {
+            players[i].games_left = settings.games_per_player;
+
+            start_game(i);
+        }
+    }
+
+    // The scheduler: wake up each player when its think time is over, until every player has finished:
+
+    {
+        unique_lock<mutex> lock(players_mutex);
+
+        while (players_finished < settings.players)
+        {
+            if (wake_ups.empty())
+            {
+                changed.wait(lock);
+                continue;
+            }
+
+            if (chrono::steady_clock::now() < wake_ups.top().when)
+            {
+                changed.wait_until(lock, wake_ups.top().when);
+                continue;
+            }
+
+            int player_number = wake_ups.top().player_number;
+
+            wake_ups.pop();
+
+            play_user_move(player_number);
+        }
+    }
+
+    load_report report;
+
+    report.games = games_finished;
+    report.comp_moves = comp_moves;
+    report.user_moves = user_moves;
+    report.timed_out_moves = timed_out_moves;
+    report.wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report.cpu_seconds = double(clock() - cpu_start) / CLOCKS_PER_SEC;
+    report.games_per_second = games_finished / report.wall_seconds;
+    report.comp_moves_per_second = comp_moves / report.wall_seconds;
+    report.cpu_milliseconds_per_game = (games_finished == 0) ? 0 : 1000 * report.cpu_seconds / games_finished;
+    report.p50_microseconds = histogram.get_percentile(0.5);
+    report.p99_microseconds = histogram.get_percentile(0.99);
+    report.p999_microseconds = histogram.get_percentile(0.999);
+    report.max_microseconds = histogram.get_max();
+    report.mean_microseconds = histogram.get_mean();
+
+    return report;
+}
+
+inline const latency_histogram& load_generator::get_histogram() const
+{
+    return histogram;
+}
+
+// LOAD_GENERATOR PUBLIC STATIC METHODS:
+
+inline void load_generator::print_report(ostream& out, const load_report& report)
+{
+    out << report.games << " games (" << report.comp_moves << " computer moves, " << report.user_moves
+        << " user moves) in " << report.wall_seconds << " seconds\n";
+    out << "Throughput: " << report.games_per_second << " games/sec, " << report.comp_moves_per_second
+        << " computer moves/sec\n";
+    out << "CPU: " << report.cpu_seconds << " seconds, " << report.cpu_milliseconds_per_game << " ms per game\n";
+    out << "Computer move latency (microseconds): p50 " << report.p50_microseconds << ", p99 " << report.p99_microseconds
+        << ", p999 " << report.p999_microseconds << ", max " << report.max_microseconds << ", mean "
+        << report.mean_microseconds << "\n";
+
+    if (report.timed_out_moves != 0)
+    {
+        out << report.timed_out_moves << " computer moves timed out, and were played at random.\n";
+    }
+}
+
+// LOAD_GENERATOR PRIVATE METHODS:
+
+inline void load_generator::start_game(int player_number)
+{
+    player& p = players[player_number];
+
+    p.board.assign(3, vector<char>(3, ' '));
+    p.depth = 0;
+    p.is_comp_turn = (next_random() % 1000000) < settings.comp_first_fraction * 1000000;
+
+    next_turn(player_number);
+}
+
+inline void load_generator::next_turn(int player_number)
+{
+    player& p = players[player_number];
+
+    if (position::three_in_a_row(p.board, 'C') || position::three_in_a_row(p.board, 'U') || p.depth == 9)
+    {
+        games_finished ++;
+        p.games_left --;
+
+        if (p.games_left > 0)
+        {
+            start_game(player_number);
+        }
+
+        else
+        {
+            players_finished ++;
+            changed.notify_all();
+        }
+
+        return;
+    }
+
+    if (!p.is_comp_turn) // the user thinks for a while, and the scheduler wakes them up when they're done.
+    {
+        long long think = (settings.average_think_milliseconds == 0) ? 0 :
+                          next_random() % (2 * settings.average_think_milliseconds * 1000LL + 1);
+
+        wake_ups.push({chrono::steady_clock::now() + chrono::microseconds(think), player_number});
+        changed.notify_all();
+        return;
+    }
+
+    search_request request;
+
+    request.board = p.board;
+    request.is_comp_turn = true;
+    request.depth = p.depth;
+
+    if (settings.move_deadline_milliseconds > 0)
+    {
+        request.budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(settings.move_deadline_milliseconds);
+    }
+
+    p.move_submitted = chrono::steady_clock::now();
+
+    eng.submit(request, [this, player_number](const search_result& result)
+    {
+        lock_guard<mutex> lock(players_mutex);
+
+        on_comp_move(player_number, result);
+    });
+}
+
+inline void load_generator::play_user_move(int player_number)
+{
+    play_random_move(players[player_number]);
+
+    user_moves ++;
+
+    next_turn(player_number);
+}
+
+inline void load_generator::on_comp_move(int player_number, const search_result& result)
+{
+    player& p = players[player_number];
+
+    histogram.record(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - p.move_submitted).count());
+
+    comp_moves ++;
+
+    if (result.best_move.row == -1) // not even one move was searched in time.
+    {
+        timed_out_moves ++;
+
+        play_random_move(p);
+    }
+
+    else
+    {
+        p.board[result.best_move.row][result.best_move.col] = 'C';
+        p.depth ++;
+        p.is_comp_turn = false;
+    }
+
+    next_turn(player_number);
+}
+
+inline void load_generator::play_random_move(player& p)
+{
+    int empty_squares = 9 - p.depth;
+    int chosen = next_random() % empty_squares;
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (p.board[square / 3][square % 3] == ' ' && chosen-- == 0)
+        {
+            p.board[square / 3][square % 3] = p.is_comp_turn ? 'C' : 'U';
+            break;
+        }
+    }
+
+    p.depth ++;
+    p.is_comp_turn = !p.is_comp_turn;
+}
+
+inline unsigned long long load_generator::next_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+
+    return random_state;
+}
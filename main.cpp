@@ -4,11 +4,33 @@
 #include <memory>
 #include <time.h>
 #include <cstdlib>
+#include <algorithm>
+#include <sstream>
+#include <set>
 
 #include "position.h"
+#include "ponder.h"
+#include "engine.h"
+#include "tree_store.h"
+#include "tree_exporter.h"
+#include "regression_harness.h"
+#include "mcts.h"
+#include "ultimate.h"
+#include "qubic.h"
+#include "rules.h"
+#include "perft.h"
+#include "tictactoe_api.h"
+#include "game_log_analyzer.h"
+#include "bounded_search.h"
+#include "load_generator.h"
+#include "threat_search.h"
+#include "opening_book.h"
+#include "position_index.h"
 
 using namespace std;
 
+void play_session(istream& in, ostream& out, bool stall); // the whole game driver, defined at the bottom (before main).
+
 vector <vector<char>> create_2d_vector()
 {
     vector <vector<char>> board;
@@ -61,16 +83,19 @@ void test_embedded_ranged_for_loop()
     // TEST PASSED.
 
 
-    // Now let's make CHANGES to the outside for loop, and it SHOULD affect the inner loop (since it is all by reference):
+    // Now let's make CHANGES to the outside for loop, and it SHOULD affect the inner loop (since it is all by reference).
+    // position::coordinates is const, so this is done on a copy of it:
 
     cout << "\n\n\n\n";
 
-    for (coordinate& i: position::coordinates)
+    vector<coordinate> copy = position::coordinates;
+
+    for (coordinate& i: copy)
     {
         i.row = -1;
         i.col = -1;
 
-        for (coordinate& temp: position::coordinates)
+        for (coordinate& temp: copy)
         {
             cout << "(" << temp.row << "," << temp.col << "), ";
         }
@@ -85,17 +110,16 @@ void test_embedded_ranged_for_loop()
 
 void test_static_methods()
 {
-    // create_vector and shuffle methods:
+    // create_vector method:
 
     for (int i = 0; i < 5; i++)
     {
         position p1;
 
-        // On iteration 1, the create_vector function intialized the coordinates vector and shuffled it.
+        // The create_vector function intialized the coordinates vector (center, corners, then edges), when the program
+        // started.
 
-        // And on each GENERAL iteration, the coordinates vector is shuffled.
-
-        // This can be seen from observing the printout for each iteration.
+        // It never changes after that (creating a position doesn't touch it), so every iteration prints the same order.
 
         for (const coordinate& temp: position::coordinates)
         {
@@ -251,332 +275,1859 @@ void test_loadtime()
     cout << "Time was " << (difference / 50.0) << " seconds.\n";
 }
 
-void examine_data_type_sizes()
+void test_lazy_expansion()
 {
+    // A lazy position should get the same evaluation as a normal one, without keeping any of the position objects
+    // its search created. Its future positions are only built when asked for, and they should have exact evaluations.
 
-    vector <int> temp;
+    position::number_of_instances = 0;
 
-    for (int i = 1; i <= 100000; i++)
+    position eager_p(create_2d_vector(), true, 0, 100000, 100000);
+
+    cout << "Eager instances: " << position::number_of_instances << "\n";
+
+    position::number_of_instances = 0;
+
+    position lazy_p(create_2d_vector(), true, 0, 100000, 100000, true);
+
+    cout << "Lazy instances: " << position::number_of_instances << "\n";
+
+    if (lazy_p.get_evaluation() != eager_p.get_evaluation() || lazy_p.get_future_positions_size() != 0)
     {
-        temp.push_back(i);
+        cout << "Bad!";
     }
 
-    cout << "temp: " << sizeof(temp) << "\n";
+    // Open every future position of the root, and check each one against a position built from scratch:
 
+    lazy_p.expand_future_positions();
 
-    cout << "bool: " << sizeof(bool) << "\n";
-    cout << "char: " << sizeof(char) << "\n";
-    cout << "int: " << sizeof(int) << "\n";
-    cout << "double: " << sizeof(double) << "\n";
-    cout << "vector<vector<char>>: " << sizeof(vector<vector<char>>) << "\n";
-    cout << "vector<unique_ptr<position>>: " << sizeof(vector<unique_ptr<position>>) << "\n";
-    cout << "vector<coordinate>: " << sizeof(vector<coordinate>) << "\n";
-    cout << "raw int pointer: " << sizeof(int*) << "\n";
-    cout << "raw double pointer: " << sizeof(double*) << "\n";
-    cout << "raw position pointer: " << sizeof(position*) << "\n";
-    cout << "unique_ptr: " << sizeof(unique_ptr<int>) << "\n";
-    cout << "shared_ptr: " << sizeof(shared_ptr<int>) << "\n";
-    cout << "weak_ptr: " << sizeof(weak_ptr<int>) << "\n";
-    cout << "int&: " << sizeof(int&) << "\n";
-    cout << "double&: " << sizeof(double&) << "\n";
-    cout << "coordinate: " << sizeof(coordinate) << "\n";
-    cout << "position: " << sizeof(position) << "\n";
+    if (lazy_p.get_future_positions_size() != 9)
+    {
+        cout << "Bad!";
+    }
 
-    position p1;
+    for (int i = 0; i < lazy_p.get_future_positions_size(); i++)
+    {
+        unique_ptr<position> child = lazy_p.get_a_future_position(i);
 
-    cout << "p1: " << sizeof(p1) << "\n";
+        position from_scratch(child->get_board(), child->get_is_comp_turn(), child->get_depth(), 100000, 100000);
+
+        if (child->get_evaluation() != from_scratch.get_evaluation())
+        {
+            cout << "Bad!";
+        }
+    }
+
+    // Expanding again should do nothing, since the result is remembered:
+
+    lazy_p.expand_future_positions();
+
+    if (lazy_p.get_future_positions_size() != 9)
+    {
+        cout << "Bad!";
+    }
 }
 
-void set_pregame_data(bool& user_goes_first, bool& x_represents_user)
+void test_pondering()
 {
-    cout << "Type y to go first, and n for the computer to go first: ";
+    // Every pondered reply should match a position searched from scratch after the same move. Also, stopping the
+    // ponderer part of the way through should never hand back a half-searched position.
 
-    char user_input = ' ';
+    vector <vector<char>> board = create_2d_vector();
 
-    cin >> user_input;
+    string pieces = "C        ";
 
-    if (user_input == 'y')
+    fill_board(board, pieces);
+
+    ponderer ponder;
+
+    for (int index = 1; index < 9; index++)
     {
-        user_goes_first = true;
-    }
+        ponder.start(board, 1);
 
-    cout << "Type x or o for what piece you want: ";
+        // Give the background thread a moment to work:
 
-    cin >> user_input;
+        int start_time = time(NULL);
 
-    if (user_input == 'x')
+        while (time(NULL) - start_time < 1)
+        {
+        }
+
+        unique_ptr<position> pondered = ponder.take(index / 3, index % 3);
+
+        vector <vector<char>> temp_board = board;
+
+        temp_board[index / 3][index % 3] = 'U';
+
+        position from_scratch(temp_board, true, 2, 100000, 100000);
+
+        if (pondered == nullptr || pondered->get_evaluation() != from_scratch.get_evaluation())
+        {
+            cout << "Bad!";
+        }
+    }
+
+    // Now take immediately, which usually cancels a search in progress:
+
+    for (int index = 1; index < 9; index++)
     {
-        x_represents_user = true;
+        ponder.start(board, 1);
+
+        unique_ptr<position> pondered = ponder.take(index / 3, index % 3);
+
+        vector <vector<char>> temp_board = board;
+
+        temp_board[index / 3][index % 3] = 'U';
+
+        position from_scratch(temp_board, true, 2, 100000, 100000);
+
+        if (pondered != nullptr && pondered->get_evaluation() != from_scratch.get_evaluation())
+        {
+            cout << "Bad!";
+        }
     }
 }
 
-void display_board(vector <vector<char>> board, bool x_represents_user, int evaluation)
+void test_async_engine()
 {
-    // First, change the 'C' and 'U' in board to 'X' and 'O', depending on if 'X' or 'O' represents the user...
+    engine e;
 
-    for (int row = 0; row < 3; row++)
+    // Search a few positions at once, and check each against a position searched the normal way:
+
+    vector <string> all_pieces = {"         ", "C        ", "C   U    ", "CU  C    ", "CUCCUU CU"};
+    vector <bool> turns = {true, false, true, false, true};
+    vector <future<search_result>> results;
+
+    for (size_t i = 0; i < all_pieces.size(); i++)
     {
-        for (int col = 0; col < 3; col++)
-        {
-            if (board[row][col] == 'U')
-            {
-                if (x_represents_user)
-                {
-                    board[row][col] = 'X';
-                }
+        search_request request;
 
-                else
-                {
-                    board[row][col] = 'O';
-                }
-            }
+        request.board = create_2d_vector();
+        fill_board(request.board, all_pieces[i]);
+        request.is_comp_turn = turns[i];
+        request.depth = 9 - count(all_pieces[i].begin(), all_pieces[i].end(), ' ');
 
-            else if (board[row][col] == 'C')
-            {
-                if (x_represents_user) // so 'O' represents the computer:
-                {
-                    board[row][col] = 'O';
-                }
+        results.push_back(e.submit(request));
+    }
 
-                else
-                {
-                    board[row][col] = 'X';
-                }
-            }
+    // Each result is checked as it comes in, so the positions below are created while the other searches are still
+    // running (including a depth 0 one, which is fine since nothing a search reads ever changes):
+
+    for (size_t i = 0; i < all_pieces.size(); i++)
+    {
+        search_result result = results[i].get();
+
+        vector <vector<char>> board = create_2d_vector();
+
+        fill_board(board, all_pieces[i]);
+
+        position p1(board, turns[i], 9 - count(all_pieces[i].begin(), all_pieces[i].end(), ' '), 100000, 100000);
+
+        if (!result.completed || result.evaluation != p1.get_evaluation())
+        {
+            cout << "Bad!";
         }
     }
 
-    // Before I start printing the board to the screen, I want to figure out what I'm going to say to the user about
-    // the position's evaluation.
+    // A search whose deadline has already passed, and one that's cancelled right away, should both stop early
+    // (or finish, if they were quick enough) without ever giving a wrong answer:
 
-    string evaluation_message = "";
+    search_request late_request;
 
-    if (evaluation == -1)
+    late_request.board = create_2d_vector();
+    late_request.budget.deadline = chrono::steady_clock::now();
+
+    search_result late_result = e.submit(late_request).get();
+
+    if (!late_result.completed && !late_result.timed_out)
     {
-        evaluation_message = "EVALUATION: You are winning!"; // since the computer is losing.
+        cout << "Bad!";
     }
 
-    else if (evaluation == 1)
+    search_request cancelled_request;
+
+    cancelled_request.board = create_2d_vector();
+    cancelled_request.token.cancel();
+
+    search_result cancelled_result = e.submit(cancelled_request).get();
+
+    if (!cancelled_result.cancelled || cancelled_result.moves_searched != 0)
     {
-        evaluation_message = "EVALUATION: The computer is winning!";
+        cout << "Bad!";
     }
 
-    else // evaluation = 0
+    // Progress updates, delivered through a callback instead of a future:
+
+    search_request progress_request;
+
+    progress_request.board = create_2d_vector();
+    progress_request.on_progress = [](const search_progress& progress)
     {
-        evaluation_message = "EVALUATION: The game is equal!";
-    }
+        cout << "Searched " << progress.moves_searched << "/" << progress.moves_total << ", best so far ("
+             << progress.best_move.row << "," << progress.best_move.col << ") = " << progress.best_evaluation << "\n";
+    };
 
-    cout << "\n    A   B   C\n\n";
+    promise<void> done;
 
-    for (int row = 0; row < 3; row++)
+    e.submit(progress_request, [&done](const search_result& result)
     {
-        cout << (row + 1) << "   ";
+        cout << "Done: " << result.evaluation << "\n";
+        done.set_value();
+    });
 
-        for (int col = 0; col < 3; col++)
+    done.get_future().wait();
+}
+
+void test_tree_store()
+{
+    tree_store tree;
+
+    tree.build(create_2d_vector(), true);
+
+    // The full game tree from an empty board has 549946 positions, and 255168 of them are finished games: 131184 won by
+    // whoever goes first, 77904 won by whoever goes second, and 46080 drawn.
+
+    int comp_wins = 0;
+    int user_wins = 0;
+    int draws = 0;
+
+    tree.for_each_breadth_first([&](int i)
+    {
+        if (tree.get_child_count(i) == 0)
         {
-            cout << board[row][col];
+            if (tree.get_score(i) == 1)
+            {
+                comp_wins ++;
+            }
 
-            if (col < 2)
+            else if (tree.get_score(i) == -1)
             {
-                cout << " | ";
+                user_wins ++;
             }
-        }
 
-        if (row == 1) // I want to print the evaluation message:
-        {
-            cout << "\t" << evaluation_message;
+            else
+            {
+                draws ++;
+            }
         }
+    });
 
-        cout << "\n";
+    if (tree.get_size() != 549946 || comp_wins != 131184 || user_wins != 77904 || draws != 46080)
+    {
+        cout << "Bad!";
+    }
 
-        if (row < 2)
+    // Every node one and two moves ahead should have the same score as a position searched from scratch:
+
+    for (int i = 0; i < 1 + 9 + 72; i++)
+    {
+        position p1(tree.get_board(i), tree.get_is_comp_turn(i), tree.get_depth(i), 100000, 100000);
+
+        if (p1.get_evaluation() != tree.get_score(i))
         {
-            cout << "   ---|---|---\n";
+            cout << "Bad!";
         }
     }
+
+    // Time how long it takes to scan every node's score, many times over:
+
+    clock_t start_time = clock();
+
+    long long total = 0;
+
+    for (int pass = 0; pass < 100; pass++)
+    {
+        tree.for_each_breadth_first([&](int i) { total += tree.get_score(i); });
+    }
+
+    cout << "100 scans of " << tree.get_size() << " nodes took " << double(clock() - start_time) / CLOCKS_PER_SEC
+         << " seconds (total " << total << ").\n";
 }
 
-void play_game()
+void test_tree_export()
 {
-    bool user_goes_first = false;
-    bool x_represents_user = false;
+    // Binary: the root is written last, with id 0 and parent id -1.
 
-    set_pregame_data(user_goes_first, x_represents_user);
+    ostringstream binary_out;
 
-    unique_ptr<position> pos = make_unique<position>(create_2d_vector(), !user_goes_first, 0, 100000, 100000);
-    // pos represents the current position of the game.
-    // sending !user_goes_first as argument because class attribute stores true if COMP goes first.
+    clock_t start_time = clock();
 
-    cout << "\nSTARTING POSITION:\n";
+    tree_exporter binary_exporter(binary_out, export_binary);
 
-    display_board(pos->get_board(), x_represents_user, pos->get_evaluation());
+    int score = binary_exporter.export_tree(create_2d_vector(), true);
 
-    cout << "\n\n\n";
+    cout << "Binary export of " << binary_exporter.get_nodes_written() << " nodes took "
+         << double(clock() - start_time) / CLOCKS_PER_SEC << " seconds.\n";
 
-    while (!pos->did_computer_win() && !pos->did_opponent_win() && !pos->is_game_drawn()) // while the game is still going on...
+    string binary = binary_out.str();
+
+    if (score != 0 || binary_exporter.get_nodes_written() != 549946 || binary.size() != 549946 * 16)
     {
-        if (pos->get_is_comp_turn() == true) // computer's turn:
-        {
-            int start_time = time(NULL); // Will be used to make sure the computer takes 2 seconds to stall:
+        cout << "Bad!";
+    }
 
-            // First, I want to directly access the future_positions vector. I'll be moving it out of the position
-            // object, but that's okay (the position object doesn't need it anymore):
+    string root = binary.substr(binary.size() - 16);
 
-            vector <unique_ptr<position>> candidate_moves = pos->get_future_positions(); // function MOVES future_positions.
+    if (root.substr(0, 4) != string(4, '\0') || root.substr(4, 4) != string(4, '\xff'))
+    {
+        cout << "Bad!";
+    }
 
-            pos->set_future_positions_size(0); // since the position object's future_positions vector is dead now.
+    // Text: one line per node, and the last line is the root.
 
-            // Next step: look through the candidate moves vector to find the best move.
+    ostringstream text_out;
 
-            // To do this, only keep positions with the same evaluation as the current position, since in minimax
-            // the current position has the same evaluation as the best positions after it (since the computer picks the
-            // best option).
+    tree_exporter text_exporter(text_out, export_text, 4096); // small buffer, so it gets flushed many times.
 
-            vector <unique_ptr<position>> best_moves;
+    text_exporter.export_tree(create_2d_vector(), false);
 
-            for (int i = 0; i < candidate_moves.size(); i++)
-            {
-                if (candidate_moves[i]->get_evaluation() == pos->get_evaluation())
-                {
-                    best_moves.push_back(move(candidate_moves[i]));
-                }
-            }
+    string text = text_out.str();
 
-            // Now to randomly pick one of the moves in best_moves, since they are all equally the best:
+    if (count(text.begin(), text.end(), '\n') != 549946)
+    {
+        cout << "Bad!";
+    }
 
-            if (best_moves.size() == 0)
-            {
-                throw runtime_error("No best moves...\n");
-            }
+    string last_line = text.substr(text.rfind('\n', text.size() - 2) + 1);
 
-            int index = rand() % best_moves.size();
+    if (last_line != "0 -1 ......... U 0 0\n")
+    {
+        cout << "Bad!";
+    }
+}
 
-            // Now to set pos to this new position's board, which the computer will play:
+void test_regressions()
+{
+    // Every faster code path has to play exactly like the reference minimax, and be no more than 25% slower than the
+    // saved baseline:
 
-            vector <vector<char>> new_board = best_moves[index]->get_board();
+    if (regression_harness::run_differential_check(cout) != 0)
+    {
+        cout << "Bad!";
+    }
 
-            pos = make_unique<position>(new_board, !pos->get_is_comp_turn(), pos->get_depth() + 1, 100000, 100000);
-            // creates FROM SCRATCH.
+    perf_gate_result gate = regression_harness::run_perf_gate(cout, "perf_baseline.txt", 0.25);
 
-            // Now before displaying the computer's move, I want to make sure it has stalled for 2 seconds, in order to
-            // not make things too confusing & fast for the user:
+    if (gate == perf_gate_failed)
+    {
+        cout << "Bad!";
+    }
 
-            while (time(NULL) - start_time < 1)
-            {
-                // deliberately left empty, just using this loop to stall if 2 seconds haven't passed yet.
-            }
+    else if (gate == perf_gate_no_baseline)
+    {
+        cout << "Perf gate not checked: there was no baseline to compare against (run again to check it).\n";
+    }
+}
 
-            cout << "COMPUTER'S MOVE:\n";
+void test_mcts()
+{
+    search_budget budget;
 
-            display_board(pos->get_board(), x_represents_user, pos->get_evaluation());
-        }
+    budget.max_nodes = 20000;
 
-        else // user's turn:
-        {
-            string coordinates = "";
+    // 3x3, computer to move with two in a row ("CC " on the top row): it should take the win on square 2.
 
-            cout << "Enter coordinates to move: ";
+    mnk_board board(3, 3, 3);
 
-            cin >> coordinates;
+    board.make_move(0, true);
+    board.make_move(1, true);
+    board.make_move(4, false);
+    board.make_move(8, false);
 
-            while (!pos->is_valid_move(coordinates))
-            {
-                cout << "You entered an invalid move. Please try again: ";
+    mcts_engine win_engine(board, true);
 
-                cin >> coordinates;
-            }
+    if (win_engine.search(budget).best_move != 2)
+    {
+        cout << "Bad!";
+    }
 
-            // Now that I know the user inputted valid coordinates, convert them to row and col:
+    // Same board, but the user to move: the user can't win on the spot (the computer's two in a row doesn't help
+    // them), but they have to block square 2. Using PUCT this time, and 2 threads:
 
-            char letter = coordinates[0];
-            char digit = coordinates[1];
+    mcts_engine block_engine(board, false, 2, true);
 
-            int row = (digit - '0') - 1;
-            int col = 0;
+    if (block_engine.search(budget).best_move != 2)
+    {
+        cout << "Bad!";
+    }
 
-            if (letter == 'A' || letter == 'a')
-            {
-                col = 0;
-            }
+    // Tree reuse: after the user blocks on 2, the search should carry on from the kept subtree and give a legal move:
 
-            else if (letter == 'B' || letter == 'b')
-            {
-                col = 1;
-            }
+    block_engine.advance(2);
 
-            else // letter = 'C' or 'c'
-            {
-                col = 2;
-            }
+    int reply = block_engine.search(budget).best_move;
 
-            // Now to make the user's move on a temporary board:
+    if (reply < 0 || !block_engine.get_board().is_empty(reply))
+    {
+        cout << "Bad!";
+    }
 
-            vector <vector<char>> temp_board = pos->get_board();
+    // Gomoku sized board, time limited, with one thread per core:
 
-            temp_board[row][col] = 'U';
+    mnk_board big_board(15, 15, 5);
 
-            // Now to set pos to a new position object with temp_board:
+    mcts_engine big_engine(big_board, true, thread::hardware_concurrency());
 
-            pos = make_unique<position>(temp_board, !pos->get_is_comp_turn(), pos->get_depth() + 1, 100000, 100000);
-            // created FROM SCRATCH.
+    search_budget time_budget;
 
-            cout << "YOUR MOVE:\n";
+    time_budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(500);
 
-            display_board(pos->get_board(), x_represents_user, pos->get_evaluation());
-        }
+    mcts_result result = big_engine.search(time_budget);
+
+    cout << "15x15, k = 5: " << result.playouts << " playouts in " << result.seconds << " seconds ("
+         << result.playouts_per_second << " playouts/sec), best move " << result.best_move << ".\n";
+}
+
+void test_ultimate()
+{
+    // The computer has won sub-boards 0 and 1, and has two in a row in sub-board 2 (squares 0 and 1), where it has to
+    // play. Square 2 of sub-board 2 (move 20) wins the whole game:
+
+    ultimate_state state = ultimate_engine::create_start_state(true);
+
+    state.comp_squares[0] = 7;
+    state.comp_squares[1] = 7;
+    state.comp_boards = 3;
+    state.closed_boards = 3;
+    state.comp_squares[2] = 3;
+    state.user_squares[2] = 8 + 16;
+    state.user_squares[5] = 1 + 2;
+    state.forced_board = 2;
+
+    search_budget budget;
+
+    budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(200);
 
-        cout << "\n\n\n";
+    if (ultimate_engine::search(state, budget).best_move != 20)
+    {
+        cout << "Bad!";
     }
 
-    // At this point, the game has ended. I should display the winner:
+    // A whole game of the computer against itself, 50 milliseconds a move. Every move has to be legal:
 
-    if (pos->did_computer_win())
+    state = ultimate_engine::create_start_state(true);
+
+    int moves_played = 0;
+
+    while (ultimate_engine::get_outcome(state) == 0)
     {
-        cout << "The computer won!\n\n";
+        budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(50);
+
+        ultimate_search_result result = ultimate_engine::search(state, budget);
+
+        int moves[81];
+        int count = ultimate_engine::generate_moves(state, moves);
+
+        if (find(moves, moves + count, result.best_move) == moves + count)
+        {
+            cout << "Bad!";
+            break;
+        }
+
+        state = ultimate_engine::apply_move(state, result.best_move);
+
+        moves_played ++;
     }
 
-    else if (pos->did_opponent_win())
+    cout << "Self-play game over after " << moves_played << " moves, outcome " << ultimate_engine::get_outcome(state)
+         << " (1 = first player won, 2 = second player won, 3 = draw).\n";
+}
+
+void test_qubic()
+{
+    // 4x4x4 has 76 winning lines: 48 straight ones, 24 diagonals across a face, and 4 through the middle of the cube.
+
+    if (qubic_engine::line_table.size() != 76)
     {
-        cout << "You won!\n\n";
+        cout << "Bad!";
     }
 
-    else
+    for (int square = 0; square < 64; square++)
     {
-        cout << "The game is a draw!\n\n";
+        int lines = qubic_engine::lines_through_square[square].size();
+
+        if (lines != 4 && lines != 7)
+        {
+            cout << "Bad!";
+        }
     }
-}
 
-int main()
-{
-    srand(time(NULL));
+    // The computer has 3 along the bottom edge (squares 0, 1 and 2), so square 3 wins:
 
-   // position p1;
+    qubic_state state = qubic_engine::create_start_state(true);
 
-   // cout << "Number of instances: " << p1.number_of_instances << "\n";
+    state.comp = 1 + 2 + 4;
+    state.user = (uint64_t(1) << 16) + (uint64_t(1) << 32) + (uint64_t(1) << 21);
 
-    // test_loadtime();
+    search_budget budget;
 
-    // test_positions();
+    budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(200);
 
-    // test_static_methods();
+    if (qubic_engine::search(state, budget).best_move != 3)
+    {
+        cout << "Bad!";
+    }
 
-   // test_embedded_ranged_for_loop();
+    // Now it's the user's turn instead. The computer is threatening square 3, so the user has to block it:
 
-   // examine_data_type_sizes();
+    state.comp_to_move = false;
 
-    char user_input = ' ';
+    if (qubic_engine::search(state, budget).best_move != 3)
+    {
+        cout << "Bad!";
+    }
+
+    // The computer has 1 and 2 on the bottom edge, and 4 and 8 up the left edge. Square 0 is on both lines, so it makes
+    // two threats at once (squares 3 and 12), and the user can only block one of them:
+
+    state = qubic_engine::create_start_state(true);
+    state.comp = 2 + 4 + 16 + 256;
+    state.user = (uint64_t(1) << 5) + (uint64_t(1) << 10) + (uint64_t(1) << 42) + (uint64_t(1) << 60);
+
+    if (qubic_engine::find_forced_win(state, 8) != 0)
+    {
+        cout << "Bad!";
+    }
 
-    cout << "To play, press 1 and enter: ";
+    // The transposition table keeps the deeper result when two positions share an entry (keys 1 and 5 both go in
+    // entry 1 of a 4 entry table):
 
-    cin >> user_input;
+    vector<qubic_engine::table_entry> table(4);
 
-    while (user_input == '1')
+    qubic_engine::store_in_table(table, 1, 50, 8, 0, 10);
+    qubic_engine::store_in_table(table, 5, -50, 2, 0, 20);
+
+    if (table[1].key != 1 || table[1].depth != 8 || table[1].best_move != 10)
     {
-        play_game();
+        cout << "Bad!";
+    }
 
-        cout << "To play again, press 1 and enter: ";
+    qubic_engine::store_in_table(table, 5, -50, 9, 0, 20); // a deeper one does replace it.
 
-        cin >> user_input;
+    if (table[1].key != 5 || table[1].depth != 9 || table[0].depth != -1)
+    {
+        cout << "Bad!";
     }
+
+    // A whole game of the computer against itself, 20 milliseconds a move. Every move has to be on an empty square:
+
+    state = qubic_engine::create_start_state(true);
+
+    int moves_played = 0;
+    bool someone_won = false;
+
+    while ((state.comp | state.user) != ~uint64_t(0) && !someone_won)
+    {
+        budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(20);
+
+        int move = qubic_engine::search(state, budget).best_move;
+
+        if (move < 0 || (((state.comp | state.user) >> move) & 1))
+        {
+            cout << "Bad!";
+            break;
+        }
+
+        uint64_t pieces = state.comp_to_move ? state.comp | (uint64_t(1) << move) : state.user | (uint64_t(1) << move);
+
+        someone_won = qubic_engine::is_win_at(pieces, move);
+        state = qubic_engine::apply_move(state, move);
+
+        moves_played ++;
+    }
+
+    cout << "Qubic self-play game over after " << moves_played << " moves, "
+         << (someone_won ? (moves_played % 2 == 1 ? "first player won" : "second player won") : "draw") << ".\n";
+}
+
+void test_rule_variants()
+{
+    // Known results with perfect play: normal and misere tic-tac-toe are draws, and the first player wins both wild
+    // and numerical tic-tac-toe.
+
+    variant_solver<standard_rules> standard_solver;
+    variant_solver<misere_rules> misere_solver;
+    variant_solver<wild_rules> wild_solver;
+    variant_solver<numerical_rules> numerical_solver;
+
+    if (standard_solver.solve(standard_rules::start_state(true)) != 0 ||
+        misere_solver.solve(misere_rules::start_state(true)) != 0 ||
+        wild_solver.solve(wild_rules::start_state(true)) != 1 ||
+        numerical_solver.solve(numerical_rules::start_state(true)) != 1)
+    {
+        cout << "Bad!";
+    }
+
+    // The standard rules have to agree with position about every reachable position:
+
+    for (const auto& entry: regression_harness::enumerate_reachable_positions())
+    {
+        standard_rules::state s;
+
+        s.code = entry.first.first;
+        s.comp_to_move = entry.first.second;
+
+        bool game_over;
+        int value = standard_rules::get_value(s, game_over);
+
+        if (!game_over)
+        {
+            value = standard_solver.solve(s);
+        }
+
+        int reference = entry.second; // from the computer's point of view.
+
+        if ((s.comp_to_move ? value : -value) != reference)
+        {
+            cout << "Bad!";
+            break;
+        }
+    }
+
+    // In misere, the computer (to move) has squares 0 and 1, and the user has squares 6 and 8. Square 2 would make
+    // 3-in-a-row, and square 3 is the only move that wins:
+
+    misere_rules::state misere_state = misere_rules::start_state(true);
+
+    misere_state.code = 1 + 2 + (1u << (9 + 6)) + (1u << (9 + 8));
+
+    if (misere_solver.find_best_move(misere_state) != 3)
+    {
+        cout << "Bad!";
+    }
+
+    cout << "Solved states: standard " << standard_solver.get_number_of_solved_states() << ", misere "
+         << misere_solver.get_number_of_solved_states() << ", wild " << wild_solver.get_number_of_solved_states()
+         << ", numerical " << numerical_solver.get_number_of_solved_states() << ".\n";
+}
+
+void test_perft()
+{
+    // From the empty board, depth 9 reaches the end of every game, so the counts are the well known game totals:
+
+    perft_counts counts = perft::run(create_2d_vector(), true, 9);
+
+    if (counts.leaves != 255168 || counts.comp_wins != 131184 || counts.user_wins != 77904 || counts.draws != 46080)
+    {
+        cout << "Bad!";
+    }
+
+    cout << "perft(9): " << counts.nodes << " nodes in " << counts.seconds << " seconds ("
+         << counts.nodes_per_second << " nodes/sec)\n";
+
+    // The first few depths have no finished games yet, so the leaves are just 9, 9 * 8, 9 * 8 * 7, ...:
+
+    if (perft::run(create_2d_vector(), true, 1).leaves != 9 || perft::run(create_2d_vector(), true, 3).leaves != 504)
+    {
+        cout << "Bad!";
+    }
+
+    // divide() and run_parallel() have to add up to the same totals:
+
+    vector<perft_divide_entry> entries = perft::divide(create_2d_vector(), true, 9);
+
+    long long divide_leaves = 0;
+
+    for (const perft_divide_entry& entry: entries)
+    {
+        divide_leaves += entry.counts.leaves;
+    }
+
+    perft_counts parallel_counts = perft::run_parallel(create_2d_vector(), true, 9, 4);
+
+    if (entries.size() != 9 || divide_leaves != 255168 || parallel_counts.leaves != 255168 ||
+        parallel_counts.nodes != counts.nodes || parallel_counts.comp_wins != 131184)
+    {
+        cout << "Bad!";
+    }
+
+    // A thread count below 1 falls back to one per hardware thread, instead of splitting the work between none:
+
+    if (perft::run_parallel(create_2d_vector(), true, 9, 0).leaves != 255168 ||
+        perft::run_parallel(create_2d_vector(), true, 9, -3).leaves != 255168)
+    {
+        cout << "Bad!";
+    }
+
+    perft::print_divide(cout, entries);
+}
+
+void test_c_api()
+{
+    ttt_engine* engine = ttt_engine_create();
+
+    int evaluation;
+    int best_move;
+
+    if (ttt_evaluate(engine, "         ", 1, &evaluation, &best_move) != 0 || evaluation != 0 || best_move < 0 ||
+        ttt_evaluate(engine, "CCX      ", 1, &evaluation, NULL) != -1)
+    {
+        cout << "Bad!";
+    }
+
+    // Empty boards searched on a few threads at once (each with its own engine, so none of them is just a lookup):
+
+    vector<thread> threads;
+    vector<int> thread_evaluations(3, 100000);
+
+    for (int t = 0; t < 3; t++)
+    {
+        threads.emplace_back([&thread_evaluations, t]()
+        {
+            ttt_engine* own_engine = ttt_engine_create();
+
+            ttt_evaluate(own_engine, "         ", t % 2, &thread_evaluations[t], NULL);
+            ttt_engine_destroy(own_engine);
+        });
+    }
+
+    for (thread& th: threads)
+    {
+        th.join();
+    }
+
+    for (int e: thread_evaluations)
+    {
+        if (e != 0)
+        {
+            cout << "Bad!";
+        }
+    }
+
+    // Every reachable position in one batch, which has to agree with the reference scores. Each best move has to
+    // lead to a position with the same score:
+
+    map<pair<unsigned int, bool>, int> reference = regression_harness::enumerate_reachable_positions();
+
+    string boards;
+    vector<unsigned char> turns;
+
+    for (const auto& entry: reference)
+    {
+        vector <vector<char>> board = bitboard::decode(entry.first.first);
+
+        for (int square = 0; square < 9; square++)
+        {
+            boards += board[square / 3][square % 3];
+        }
+
+        turns.push_back(entry.first.second);
+    }
+
+    vector<int> evaluations(turns.size());
+    vector<int> best_moves(turns.size());
+
+    for (int pass = 1; pass <= 2; pass++) // the second pass only looks up what the first pass found.
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        if (ttt_evaluate_batch(engine, boards.data(), turns.data(), turns.size(), evaluations.data(),
+                               best_moves.data()) != 0)
+        {
+            cout << "Bad!";
+        }
+
+        cout << "Batch pass " << pass << ": " << turns.size() << " boards in "
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds\n";
+    }
+
+    int i = 0;
+
+    for (const auto& entry: reference)
+    {
+        if (evaluations[i] != entry.second)
+        {
+            cout << "Bad!";
+        }
+
+        if (best_moves[i] != -1)
+        {
+            unsigned int code = entry.first.first | (1u << (entry.first.second ? best_moves[i] : 9 + best_moves[i]));
+
+            if (reference[make_pair(code, !entry.first.second)] != entry.second)
+            {
+                cout << "Bad!";
+            }
+        }
+
+        i++;
+    }
+
+    ttt_engine_destroy(engine);
+}
+
+void write_every_game(vector <vector<char>>& board, bool first_player_to_move, string& moves_so_far, ostream& out)
+{
+    if (position::three_in_a_row(board, 'C') || position::three_in_a_row(board, 'U'))
+    {
+        out << moves_so_far << "\n";
+        return;
+    }
+
+    bool is_full = true;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (board[row][col] != ' ')
+            {
+                continue;
+            }
+
+            is_full = false;
+
+            string move_text = string(1, char('a' + col)) + char('1' + row);
+
+            board[row][col] = first_player_to_move ? 'C' : 'U';
+            moves_so_far += (moves_so_far.empty() ? "" : " ") + move_text;
+
+            write_every_game(board, !first_player_to_move, moves_so_far, out);
+
+            moves_so_far.erase(moves_so_far.size() - min<size_t>(moves_so_far.size(), move_text.size() + 1));
+            board[row][col] = ' ';
+        }
+    }
+
+    if (is_full)
+    {
+        out << moves_so_far << "\n";
+    }
+}
+
+void test_game_log_analyzer()
+{
+    game_log_analyzer analyzer;
+
+    // After b2, a2 (next to the centre) loses for the second player, and a1 (a corner) doesn't:
+
+    game_analysis game = analyzer.analyze_game("b2 a2 a1 c3 c1 b1 a3", 1);
+
+    if (game.result != 1 || game.blunders.size() != 1 || game.blunders[0].move_number != 2 ||
+        game.blunders[0].result_before != 0 || game.blunders[0].result_after != -1)
+    {
+        cout << "Bad!";
+    }
+
+    // Here a3 doesn't stop the user's a1, b1, c1, so it's a blunder (and the user wins):
+
+    game = analyzer.analyze_game("b2 a1 c3 c1 a3 b1", 2);
+
+    if (game.result != 2 || game.blunders.size() != 1 || game.blunders[0].move_number != 5 ||
+        analyzer.analyze_game("b2 b2", 3).invalid_move_number != 2 ||
+        analyzer.analyze_game("b2 d1", 4).invalid_move_number != 2)
+    {
+        cout << "Bad!";
+    }
+
+    // Every possible game, plus a few broken lines. The totals have to match the well known game counts:
+
+    stringstream log;
+    vector <vector<char>> board = create_2d_vector();
+    string moves_so_far;
+
+    write_every_game(board, true, moves_so_far, log);
+
+    log << "a1 a1\n" << "zz\n" << "a1 b1 a2 b2 a3 c3\n";
+
+    stringstream report;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    analysis_totals totals = analyzer.run(log, report);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (totals.games != 255171 || totals.invalid_games != 3 || totals.first_player_wins != 131184 ||
+        totals.second_player_wins != 77904 || totals.draws != 46080 || totals.unfinished != 0)
+    {
+        cout << "Bad!";
+    }
+
+    // The report has to be in the same order as the log:
+
+    string first_line;
+
+    getline(report, first_line);
+
+    if (first_line.find("Game 1:") != 0)
+    {
+        cout << "Bad!";
+    }
+
+    cout << totals.games << " games analyzed in " << seconds << " seconds (" << totals.games / seconds
+         << " games/sec)\n";
+
+    game_log_analyzer::write_totals(cout, totals);
+}
+
+void test_bounded_search()
+{
+    // Plenty of budget on a normal board: it should see all the way to the end, where it's a draw.
+
+    search_budget budget;
+
+    budget.deadline = chrono::steady_clock::now() + chrono::seconds(5);
+
+    bounded_search small_search(1 << 16);
+
+    bounded_search_result result = small_search.search(mnk_board(3, 3, 3), true, budget);
+
+    if (result.hit_budget || result.score != 0 || small_search.get_table().get_size_in_bytes() > (1 << 16))
+    {
+        cout << "Bad!";
+    }
+
+    // 4x4 with 3 in a row is a win for whoever goes first:
+
+    result = small_search.search(mnk_board(4, 4, 3), true, budget);
+
+    if (result.score <= 0)
+    {
+        cout << "Bad!";
+    }
+
+    // Gomoku with a 64 KB table and a node budget. The computer has 4 in a row with both ends open, so it has to win
+    // right away, and the search has to stop at the node budget:
+
+    mnk_board gomoku(15, 15, 5);
+
+    for (int col = 5; col <= 8; col++)
+    {
+        gomoku.make_move(7 * 15 + col, true);
+        gomoku.make_move(9 * 15 + col, false);
+    }
+
+    budget.max_nodes = 50000;
+
+    bounded_search big_search(1 << 16);
+
+    result = big_search.search(gomoku, true, budget);
+
+    if ((result.best_move != 7 * 15 + 4 && result.best_move != 7 * 15 + 9) || result.score < 0)
+    {
+        cout << "Bad!";
+    }
+
+    // Now an open position with no quick win, where the budget has to run out first. There still has to be a move:
+
+    mnk_board quiet(15, 15, 5);
+
+    quiet.make_move(7 * 15 + 7, true);
+    quiet.make_move(8 * 15 + 8, false);
+
+    result = big_search.search(quiet, true, budget);
+
+    if (!result.hit_budget || result.nodes > budget.max_nodes || result.best_move < 0 || !quiet.is_empty(result.best_move))
+    {
+        cout << "Bad!";
+    }
+
+    cout << "Budgeted gomoku search: depth " << result.depth << ", " << result.nodes << " nodes, table of "
+         << big_search.get_table().get_size_in_bytes() << " bytes, " << big_search.get_table().get_replacements()
+         << " replacements\n";
+}
+
+void test_tracing()
+{
+    // Only meaningful when built with ENGINE_TRACING.
+
+    if (!tracing::is_enabled())
+    {
+        cout << "Tracing is off (build with -DENGINE_TRACING to turn it on).\n";
+        return;
+    }
+
+    tracing::clear();
+
+    position p(create_2d_vector(), true, 1, 100000, 100000);
+
+    stringstream folded;
+    stringstream chrome;
+
+    tracing::write_folded_stacks(folded);
+    tracing::write_chrome_trace(chrome);
+
+    // Each child is built inside its parent's minimax(), so that stack has to be there:
+
+    if (folded.str().find("minimax;construct_child;minimax") == string::npos ||
+        folded.str().find("three_in_a_row") == string::npos || chrome.str().find("{\"traceEvents\":[") != 0)
+    {
+        cout << "Bad!";
+    }
+
+    cout << tracing::get_events_recorded() << " events recorded. The 5 busiest stacks:\n";
+
+    // Sort the folded lines by time, biggest first:
+
+    vector<pair<long long, string>> stacks;
+    string line;
+
+    while (getline(folded, line))
+    {
+        size_t space = line.rfind(' ');
+
+        stacks.push_back(make_pair(stoll(line.substr(space + 1)), line.substr(0, space)));
+    }
+
+    sort(stacks.rbegin(), stacks.rend());
+
+    for (size_t i = 0; i < 5 && i < stacks.size(); i++)
+    {
+        cout << stacks[i].first << " ns: " << stacks[i].second << "\n";
+    }
+}
+
+void test_load_generator()
+{
+    engine e;
+
+    // The users always move first, so no search starts from an empty board (the slowest kind), and the test stays
+    // quick. Every game has a computer move, and between 2 and 4 of them:
+
+    load_settings settings;
+
+    settings.players = 200;
+    settings.games_per_player = 2;
+    settings.average_think_milliseconds = 5;
+    settings.comp_first_fraction = 0;
+
+    load_generator generator(e, settings);
+
+    load_report report = generator.run();
+
+    if (report.games != 400 || report.comp_moves != generator.get_histogram().get_count() ||
+        report.comp_moves < 400 * 1 || report.comp_moves > 400 * 4 || report.user_moves < report.comp_moves ||
+        report.timed_out_moves != 0 || report.p50_microseconds > report.p99_microseconds ||
+        report.p99_microseconds > report.p999_microseconds || report.p999_microseconds > report.max_microseconds)
+    {
+        cout << "Bad!";
+    }
+
+    // The histogram on its own: 1 to 1000 microseconds, once each:
+
+    latency_histogram histogram;
+
+    for (int i = 1; i <= 1000; i++)
+    {
+        histogram.record(i);
+    }
+
+    if (histogram.get_percentile(0.5) < 500 || histogram.get_percentile(0.5) > 500 * 1.07 ||
+        histogram.get_percentile(0.99) < 990 || histogram.get_max() != 1000 || histogram.get_mean() != 500.5)
+    {
+        cout << "Bad!";
+    }
+
+    load_generator::print_report(cout, report);
+}
+
+void test_threat_search()
+{
+    search_budget budget;
+
+    budget.max_nodes = 1000000;
+
+    // Gomoku. The computer makes two open threes with one move ((7, 8) is in both), which the user can't stop:
+
+    mnk_board gomoku(15, 15, 5);
+
+    const int comp_squares[] = {7 * 15 + 6, 7 * 15 + 7, 5 * 15 + 8, 6 * 15 + 8};
+    const int user_squares[] = {0, 14, 14 * 15, 14 * 15 + 14};
+
+    for (int i = 0; i < 4; i++)
+    {
+        gomoku.make_move(comp_squares[i], true);
+        gomoku.make_move(user_squares[i], false);
+    }
+
+    threat_search threats(gomoku);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    threat_search_result result = threats.find_forced_win(gomoku, true, 10, budget);
+
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (!result.found || result.best_move != 7 * 15 + 8 || result.hit_budget)
+    {
+        cout << "Bad!";
+    }
+
+    cout << "Double three found in " << milliseconds << " ms, " << result.nodes << " nodes, win in " << result.plies
+         << " plies\n";
+
+    // The user has no win there (it's the computer's position, and the user has nothing):
+
+    if (threats.find_forced_win(gomoku, false, 10, budget).found)
+    {
+        cout << "Bad!";
+    }
+
+    // The first pass of bounded_search finds the double three too, without using up its budget:
+
+    search_budget small_budget;
+
+    small_budget.max_nodes = 50000;
+
+    bounded_search search(1 << 16);
+
+    bounded_search_result full = search.search(gomoku, true, small_budget);
+
+    if (full.best_move != 7 * 15 + 8 || full.score <= 0 || full.hit_budget)
+    {
+        cout << "Bad!";
+    }
+
+    // If the user has an open four, the computer's double three is too slow:
+
+    for (int col = 2; col <= 5; col++)
+    {
+        gomoku.make_move(11 * 15 + col, false);
+    }
+
+    if (threats.find_forced_win(gomoku, true, 10, budget).found ||
+        !threats.find_forced_win(gomoku, false, 10, budget).found)
+    {
+        cout << "Bad!";
+    }
+
+    // A quiet position has no win, and that's found out quickly:
+
+    mnk_board quiet(15, 15, 5);
+
+    quiet.make_move(7 * 15 + 7, true);
+    quiet.make_move(8 * 15 + 8, false);
+
+    result = threats.find_forced_win(quiet, true, 10, budget);
+
+    if (result.found || result.nodes > 100)
+    {
+        cout << "Bad!";
+    }
+}
+
+void test_opening_book()
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    opening_book book;
+
+    double build_milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // Every position with 0, 1 or 2 pieces: 1 + 9 + 72, once for each side to move:
+
+    if (book.get_number_of_positions() != 2 * (1 + 9 + 72))
+    {
+        cout << "Bad!";
+    }
+
+    // Check the book against position, for the empty board and every position after one move. Each book move has to
+    // keep the evaluation the same:
+
+    vector <vector<vector<char>>> boards = {create_2d_vector(), create_2d_vector()};
+    vector <bool> turns = {true, false};
+
+    for (int square = 0; square < 9; square++)
+    {
+        for (char piece: {'C', 'U'})
+        {
+            boards.push_back(create_2d_vector());
+            boards.back()[square / 3][square % 3] = piece;
+            turns.push_back(piece == 'U');
+        }
+    }
+
+    for (size_t i = 0; i < boards.size(); i++)
+    {
+        const book_entry* entry = book.find(boards[i], turns[i]);
+
+        position searched(boards[i], turns[i], 1, 100000, 100000);
+
+        if (entry == nullptr || entry->moves.empty() || entry->evaluation != searched.get_evaluation())
+        {
+            cout << "Bad!";
+            continue;
+        }
+
+        for (const book_move& m: entry->moves)
+        {
+            vector <vector<char>> after = boards[i];
+
+            after[m.square.row][m.square.col] = turns[i] ? 'C' : 'U';
+
+            position child(after, !turns[i], 2, 100000, 100000);
+
+            if (m.weight < 1 || child.get_evaluation() != entry->evaluation)
+            {
+                cout << "Bad!";
+            }
+        }
+    }
+
+    // Weighted picks: only book moves come out, and every one of them comes out sometimes:
+
+    const book_entry* start_entry = book.find(create_2d_vector(), true);
+    vector<int> times_picked(9, 0);
+
+    for (int i = 0; i < 10000; i++)
+    {
+        coordinate square = {0, 0};
+
+        if (!book.pick_move(create_2d_vector(), true, square))
+        {
+            cout << "Bad!";
+            break;
+        }
+
+        times_picked[square.row * 3 + square.col] ++;
+    }
+
+    int picked_book_moves = 0;
+
+    for (const book_move& m: start_entry->moves)
+    {
+        if (times_picked[m.square.row * 3 + m.square.col] == 0)
+        {
+            cout << "Bad!";
+        }
+
+        picked_book_moves += times_picked[m.square.row * 3 + m.square.col];
+    }
+
+    if (picked_book_moves != 10000)
+    {
+        cout << "Bad!";
+    }
+
+    // A book position costs nothing, compared to searching the start of the game:
+
+    start = chrono::steady_clock::now();
+
+    unique_ptr<position> booked = book.create_position(create_2d_vector(), true);
+
+    double book_milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+
+    position searched(create_2d_vector(), true, 1, 100000, 100000);
+
+    double search_milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (booked == nullptr || booked->get_evaluation() != searched.get_evaluation())
+    {
+        cout << "Bad!";
+    }
+
+    cout << "Opening book built in " << build_milliseconds << " ms. Start of the game: " << book_milliseconds
+         << " ms from the book, " << search_milliseconds << " ms searched.\n";
+}
+
+void test_position_index()
+{
+    // Every rankable bitboard has to get a different rank, and the ranks have to fill 0 to number_of_positions - 1:
+
+    vector<int> times_ranked(position_index::number_of_positions, 0);
+    int rankable = 0;
+
+    for (unsigned int code = 0; code < (1u << 18); code++)
+    {
+        if (!position_index::is_rankable(code))
+        {
+            continue;
+        }
+
+        rankable ++;
+
+        int rank = position_index::get_rank(code);
+
+        if (rank < 0 || rank >= position_index::number_of_positions || position_index::get_code(rank) != code)
+        {
+            cout << "Bad!";
+            return;
+        }
+
+        times_ranked[rank] ++;
+    }
+
+    if (rankable != position_index::number_of_positions || count(times_ranked.begin(), times_ranked.end(), 1) != rankable)
+    {
+        cout << "Bad!";
+    }
+
+    // Base 3 goes both ways for every board:
+
+    for (int base3 = 0; base3 < position_index::number_of_base3_codes; base3++)
+    {
+        if (position_index::get_base3(position_index::get_code_from_base3(base3)) != base3)
+        {
+            cout << "Bad!";
+            break;
+        }
+    }
+
+    // The symmetric ranks: all 8 transformations of a board share one, and its canonical board is one of them:
+
+    for (int rank = 0; rank < position_index::number_of_positions; rank++)
+    {
+        unsigned int code = position_index::get_code(rank);
+        int symmetric_rank = position_index::get_symmetric_rank(code);
+        unsigned int canonical = position_index::get_canonical_code(symmetric_rank);
+        bool canonical_found = false;
+
+        for (int symmetry = 0; symmetry < 8; symmetry++)
+        {
+            unsigned int transformed = position_index::transform(code, symmetry);
+
+            if (position_index::get_symmetric_rank(transformed) != symmetric_rank ||
+                position_index::get_rank(transformed) < position_index::get_rank(canonical))
+            {
+                cout << "Bad!";
+                return;
+            }
+
+            canonical_found = canonical_found || (transformed == canonical);
+        }
+
+        if (!canonical_found)
+        {
+            cout << "Bad!";
+            return;
+        }
+    }
+
+    // Three different openings, up to symmetry: a corner, an edge, or the middle:
+
+    unsigned int corner = bitboard::encode({{'C', ' ', ' '}, {' ', ' ', ' '}, {' ', ' ', ' '}});
+    unsigned int other_corner = bitboard::encode({{' ', ' ', ' '}, {' ', ' ', ' '}, {' ', ' ', 'C'}});
+    unsigned int edge = bitboard::encode({{' ', 'C', ' '}, {' ', ' ', ' '}, {' ', ' ', ' '}});
+    unsigned int middle = bitboard::encode({{' ', ' ', ' '}, {' ', 'C', ' '}, {' ', ' ', ' '}});
+
+    if (position_index::get_symmetric_rank(corner) != position_index::get_symmetric_rank(other_corner) ||
+        position_index::get_symmetric_rank(corner) == position_index::get_symmetric_rank(edge) ||
+        position_index::get_symmetric_rank(edge) == position_index::get_symmetric_rank(middle))
+    {
+        cout << "Bad!";
+    }
+
+    cout << position_index::number_of_positions << " positions, " << position_index::get_number_of_symmetry_classes()
+         << " up to symmetry (out of " << position_index::number_of_base3_codes << " base 3 codes, and "
+         << (1 << 18) << " bitboards).\n";
+}
+
+void test_scripted_sessions()
+{
+    // Whole sessions through the same driver as a real game, with the input scripted and no stalling. The user tries
+    // every square in order (the taken ones are turned down), and the computer never loses:
+
+    const vector<string> scripts = {"1 n x a1 b1 c1 a2 b2 c2 a3 b3 c3", "1 y o b2 a1 c1 a3 c3 b1 a2 b3 c2"};
+    int sessions = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < 200; i++)
+    {
+        istringstream in(scripts[i % 2]);
+        ostringstream out;
+
+        play_session(in, out, false);
+
+        sessions ++;
+
+        const string& text = out.str();
+
+        if (text.find("STARTING POSITION:\n\n    A   B   C\n") == string::npos || text.find("You won!") != string::npos ||
+            (text.find("The computer won!") == string::npos && text.find("The game is a draw!") == string::npos))
+        {
+            cout << "Bad!";
+            break;
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // A script that runs out in the middle of a game stops it, instead of waiting for input forever:
+
+    istringstream short_script("1 y x b2");
+    ostringstream out;
+
+    play_session(short_script, out, false);
+
+    if (out.str().find("No more input") == string::npos)
+    {
+        cout << "Bad!";
+    }
+
+    // Past the book, the computer still picks randomly among its best moves. After a1, b2 (the only good reply) and c3,
+    // any of the 4 edges holds the draw, so the same script shouldn't play out the same way every time:
+
+    set<string> transcripts;
+
+    for (int i = 0; i < 40; i++)
+    {
+        istringstream tie_script("1 y x a1 c3 a2 b1 c1 b3 c2 a3 b2");
+        ostringstream tie_out;
+
+        play_session(tie_script, tie_out, false);
+
+        transcripts.insert(tie_out.str());
+    }
+
+    if (transcripts.size() < 2)
+    {
+        cout << "Bad!";
+    }
+
+    cout << sessions << " scripted sessions in " << seconds << " seconds (" << sessions / seconds << " sessions/sec)\n";
+}
+
+void examine_data_type_sizes()
+{
+
+    vector <int> temp;
+
+    for (int i = 1; i <= 100000; i++)
+    {
+        temp.push_back(i);
+    }
+
+    cout << "temp: " << sizeof(temp) << "\n";
+
+
+    cout << "bool: " << sizeof(bool) << "\n";
+    cout << "char: " << sizeof(char) << "\n";
+    cout << "int: " << sizeof(int) << "\n";
+    cout << "double: " << sizeof(double) << "\n";
+    cout << "vector<vector<char>>: " << sizeof(vector<vector<char>>) << "\n";
+    cout << "vector<unique_ptr<position>>: " << sizeof(vector<unique_ptr<position>>) << "\n";
+    cout << "vector<coordinate>: " << sizeof(vector<coordinate>) << "\n";
+    cout << "raw int pointer: " << sizeof(int*) << "\n";
+    cout << "raw double pointer: " << sizeof(double*) << "\n";
+    cout << "raw position pointer: " << sizeof(position*) << "\n";
+    cout << "unique_ptr: " << sizeof(unique_ptr<int>) << "\n";
+    cout << "shared_ptr: " << sizeof(shared_ptr<int>) << "\n";
+    cout << "weak_ptr: " << sizeof(weak_ptr<int>) << "\n";
+    cout << "int&: " << sizeof(int&) << "\n";
+    cout << "double&: " << sizeof(double&) << "\n";
+    cout << "coordinate: " << sizeof(coordinate) << "\n";
+    cout << "position: " << sizeof(position) << "\n";
+
+    memory_stats::begin_search();
+
+    position p1;
+
+    cout << "p1: " << sizeof(p1) << "\n";
+
+    // sizeof doesn't include anything on the heap, so here's everything p1 (and its search) really used:
+
+    memory_stats::print_search_report(cout);
+}
+
+void test_memory_accounting()
+{
+    // Only meaningful when built with MEMORY_ACCOUNTING. A normal search keeps its whole (pruned) tree, so its
+    // live bytes should stay high afterwards. A lazy search throws the tree away, so only its peak should be high.
+
+    long long live_before = memory_stats::get_live_bytes();
+
+    memory_stats::begin_search();
+
+    unique_ptr<position> eager_p = make_unique<position>(create_2d_vector(), true, 1, 100000, 100000);
+
+    cout << "EAGER SEARCH:\n";
+
+    memory_stats::print_search_report(cout);
+
+    memory_stats::begin_search();
+
+    unique_ptr<position> lazy_p = make_unique<position>(create_2d_vector(), true, 1, 100000, 100000, true);
+
+    cout << "LAZY SEARCH:\n";
+
+    memory_stats::print_search_report(cout);
+
+    eager_p.reset();
+    lazy_p.reset();
+
+    if (memory_stats::get_live_bytes() != live_before) // everything the two searches allocated should be freed by now.
+    {
+        cout << "Bad!";
+    }
+}
+
+void set_pregame_data(istream& in, ostream& out, bool& user_goes_first, bool& x_represents_user)
+{
+    out << "Type y to go first, and n for the computer to go first: ";
+
+    char user_input = ' ';
+
+    in >> user_input;
+
+    if (user_input == 'y')
+    {
+        user_goes_first = true;
+    }
+
+    out << "Type x or o for what piece you want: ";
+
+    in >> user_input;
+
+    if (user_input == 'x')
+    {
+        x_represents_user = true;
+    }
+}
+
+void render_board(string& render, const vector <vector<char>>& board, bool x_represents_user, int evaluation)
+{
+    // Each 'C' and 'U' is shown as an 'X' or an 'O', depending on if 'X' or 'O' represents the user:
+
+    char user_piece = x_represents_user ? 'X' : 'O';
+    char comp_piece = x_represents_user ? 'O' : 'X';
+
+    // Before I start drawing the board, I want to figure out what I'm going to say to the user about the position's
+    // evaluation:
+
+    const char* evaluation_message;
+
+    if (evaluation == -1)
+    {
+        evaluation_message = "EVALUATION: You are winning!"; // since the computer is losing.
+    }
+
+    else if (evaluation == 1)
+    {
+        evaluation_message = "EVALUATION: The computer is winning!";
+    }
+
+    else // evaluation = 0
+    {
+        evaluation_message = "EVALUATION: The game is equal!";
+    }
+
+    render += "\n    A   B   C\n\n";
+
+    for (int row = 0; row < 3; row++)
+    {
+        render += char('1' + row);
+        render += "   ";
+
+        for (int col = 0; col < 3; col++)
+        {
+            char square = board[row][col];
+
+            render += (square == 'U') ? user_piece : (square == 'C') ? comp_piece : ' ';
+
+            if (col < 2)
+            {
+                render += " | ";
+            }
+        }
+
+        if (row == 1) // I want to print the evaluation message:
+        {
+            render += "\t";
+            render += evaluation_message;
+        }
+
+        render += "\n";
+
+        if (row < 2)
+        {
+            render += "   ---|---|---\n";
+        }
+    }
+}
+
+void play_game(istream& in, ostream& out, bool stall)
+{
+    bool user_goes_first = false;
+    bool x_represents_user = false;
+
+    set_pregame_data(in, out, user_goes_first, x_represents_user);
+
+    memory_stats::begin_game(); // so the high-water mark shown at the end is for this game only.
+
+    static const opening_book book; // built once, the first time a game is played.
+
+    unique_ptr<position> pos = book.create_position(create_2d_vector(), !user_goes_first);
+    // pos represents the current position of the game.
+    // sending !user_goes_first as argument because class attribute stores true if COMP goes first.
+
+    if (pos == nullptr) // only if the book is empty.
+    {
+        pos = make_unique<position>(create_2d_vector(), !user_goes_first, 0, 100000, 100000, true);
+    }
+
+    // Every position where the computer is to move is lazy. Expanding a lazy position gives every move its exact
+    // evaluation, so all of the equally good moves can be found and one picked at random. (An eager position prunes
+    // with alpha-beta, and a move that only ties the best one gets cut off with a bound instead of its evaluation.)
+
+    // Each turn is drawn into render, and written out all at once. It's cleared (not freed) between turns, so after
+    // the first turn, drawing doesn't allocate anything:
+
+    string render = "\nSTARTING POSITION:\n";
+
+    render_board(render, pos->get_board(), x_represents_user, pos->get_evaluation());
+
+    render += "\n\n\n";
+
+    out << render;
+
+    // Each move is made on scratch_board, a copy of the current board. Copying into it again on later turns reuses its
+    // memory, so after the first turn, making a move doesn't allocate anything either:
+
+    vector <vector<char>> scratch_board = pos->get_board();
+
+    ponderer ponder; // searches the user's possible moves while they're thinking.
+
+    while (!pos->did_computer_win() && !pos->did_opponent_win() && !pos->is_game_drawn()) // while the game is still going on...
+    {
+        if (pos->get_is_comp_turn() == true) // computer's turn:
+        {
+            int start_time = time(NULL); // Will be used to make sure the computer takes 2 seconds to stall:
+
+            // Early in the game, the opening book has the best moves, so there's nothing to search:
+
+            coordinate book_square;
+
+            if (book.pick_move(pos->get_board(), true, book_square))
+            {
+                int new_depth = pos->get_depth() + 1;
+
+                scratch_board = pos->get_board();
+                scratch_board[book_square.row][book_square.col] = 'C';
+
+                pos = book.create_position(scratch_board, false);
+
+                if (pos == nullptr) // the move went past the end of the book, so it's searched the normal way.
+                {
+                    pos = make_unique<position>(scratch_board, false, new_depth, 100000, 100000);
+                }
+            }
+
+            else
+            {
+                // First, I want to directly access the future_positions vector. I'll be moving it out of the position
+                // object, but that's okay (the position object doesn't need it anymore):
+
+                pos->expand_future_positions(); // pos is lazy (see the top of this function).
+
+                vector <unique_ptr<position>> candidate_moves = pos->get_future_positions(); // function MOVES future_positions.
+
+                pos->set_future_positions_size(0); // since the position object's future_positions vector is dead now.
+
+                // Next step: look through the candidate moves vector to find the best moves.
+
+                // To do this, only count positions with the same evaluation as the current position, since in minimax
+                // the current position has the same evaluation as the best positions after it (since the computer picks
+                // the best option).
+
+                int number_of_best_moves = 0;
+
+                for (const unique_ptr<position>& candidate: candidate_moves)
+                {
+                    if (candidate->get_evaluation() == pos->get_evaluation())
+                    {
+                        number_of_best_moves ++;
+                    }
+                }
+
+                // Now to randomly pick one of the best moves, since they are all equally the best:
+
+                if (number_of_best_moves == 0)
+                {
+                    throw runtime_error("No best moves...\n");
+                }
+
+                int chosen = rand() % number_of_best_moves;
+                const position* best_move = nullptr;
+
+                for (const unique_ptr<position>& candidate: candidate_moves)
+                {
+                    if (candidate->get_evaluation() == pos->get_evaluation() && chosen-- == 0)
+                    {
+                        best_move = candidate.get();
+                        break;
+                    }
+                }
+
+                // Now to set pos to this new position's board, which the computer will play (candidate_moves is still
+                // alive, so its board can be passed straight in without a copy):
+
+                pos = make_unique<position>(best_move->get_board(), !pos->get_is_comp_turn(), pos->get_depth() + 1,
+                                            100000, 100000);
+                // creates FROM SCRATCH.
+            }
+
+            // Now before displaying the computer's move, I want to make sure it has stalled for 2 seconds, in order to
+            // not make things too confusing & fast for the user (unless nobody's watching):
+
+            while (stall && time(NULL) - start_time < 1)
+            {
+                // deliberately left empty, just using this loop to stall if 2 seconds haven't passed yet.
+            }
+
+            render.clear();
+            render += "COMPUTER'S MOVE:\n";
+
+            render_board(render, pos->get_board(), x_represents_user, pos->get_evaluation());
+        }
+
+        else // user's turn:
+        {
+            string coordinates = "";
+            coordinate square;
+
+            if (pos->get_depth() + 1 > book.get_max_pieces()) // otherwise, the book already knows the user's replies.
+            {
+                ponder.start(pos->get_board(), pos->get_depth()); // think about the user's replies until they move.
+            }
+
+            out << "Enter coordinates to move: ";
+
+            // The same parsing that checks the move also gives its row and col:
+
+            while (in >> coordinates && !pos->is_valid_move(coordinates, square))
+            {
+                out << "You entered an invalid move. Please try again: ";
+            }
+
+            if (!in) // the input ran out (e.g. the end of a scripted session), so the game can't go on.
+            {
+                ponder.stop();
+
+                out << "\nNo more input, so the game is over.\n\n";
+
+                return;
+            }
+
+            // Now to make the user's move on the scratch board:
+
+            scratch_board = pos->get_board();
+            scratch_board[square.row][square.col] = 'U';
+
+            // If the book knows the new position, or the computer already searched this move while the user was
+            // thinking, there's nothing more to do:
+
+            unique_ptr<position> booked = book.create_position(scratch_board, true);
+            unique_ptr<position> pondered = (booked != nullptr) ? nullptr : ponder.take(square.row, square.col);
+
+            if (booked != nullptr)
+            {
+                pos = move(booked);
+            }
+
+            else if (pondered != nullptr)
+            {
+                pos = move(pondered);
+            }
+
+            else
+            {
+                // Now to set pos to a new position object with scratch_board (lazy, since the computer is to move):
+
+                pos = make_unique<position>(scratch_board, !pos->get_is_comp_turn(), pos->get_depth() + 1, 100000,
+                                            100000, true);
+                // created FROM SCRATCH.
+            }
+
+            render.clear();
+            render += "YOUR MOVE:\n";
+
+            render_board(render, pos->get_board(), x_represents_user, pos->get_evaluation());
+        }
+
+        render += "\n\n\n";
+
+        out << render;
+    }
+
+    // At this point, the game has ended. I should display the winner:
+
+    if (pos->did_computer_win())
+    {
+        out << "The computer won!\n\n";
+    }
+
+    else if (pos->did_opponent_win())
+    {
+        out << "You won!\n\n";
+    }
+
+    else
+    {
+        out << "The game is a draw!\n\n";
+    }
+
+    if (memory_stats::is_enabled())
+    {
+        out << "Memory high-water mark this game: " << memory_stats::get_game_peak_bytes() << " bytes.\n\n";
+    }
+}
+
+void play_session(istream& in, ostream& out, bool stall)
+{
+    char user_input = ' ';
+
+    out << "To play, press 1 and enter: ";
+
+    while (in >> user_input && user_input == '1')
+    {
+        play_game(in, out, stall);
+
+        out << "To play again, press 1 and enter: ";
+    }
+}
+
+int main()
+{
+    srand(time(NULL));
+
+   // position p1;
+
+   // cout << "Number of instances: " << p1.number_of_instances << "\n";
+
+    // test_loadtime();
+
+    // test_lazy_expansion();
+
+    // test_pondering();
+
+    // test_async_engine();
+
+    // test_memory_accounting();
+
+    // test_tree_store();
+
+    // test_tree_export();
+
+    // test_regressions();
+
+    // test_mcts();
+
+    // test_ultimate();
+    // test_qubic();
+    // test_rule_variants();
+    // test_perft();
+    // test_c_api();
+    // test_game_log_analyzer();
+    // test_bounded_search();
+    // test_tracing();
+    // test_load_generator();
+    // test_threat_search();
+    // test_opening_book();
+    // test_position_index();
+    // test_scripted_sessions();
+
+    // test_positions();
+
+    // test_static_methods();
+
+   // test_embedded_ranged_for_loop();
+
+   // examine_data_type_sizes();
+
+    play_session(cin, cout, true);
 }
 
@@ -0,0 +1,519 @@
+/* "mcts" is a Monte Carlo Tree Search engine, for boards where searching every move to the end of the game (like
+   position's minimax does) would never finish.
+
+    - Instead of searching everything, each iteration walks down the tree picking the most promising move at each step
+      (UCT, or PUCT if asked for), adds the moves after the node it reaches, and then plays random moves from there to
+      the end of the game (a "playout"). Whoever won the playout gets credit all the way back up the path.
+    - Playouts run on a copy of an mnk_board, with the empty squares in a fixed size array, so they never allocate.
+    - After a move is played, advance() keeps the part of the tree under that move, so the work isn't thrown away.
+    - Root parallelism: with more than one thread, each thread grows its own tree from the same position, and the
+      visit counts of their first moves are added together at the end.
+    - Scores are from the computer's point of view: 1 is a computer win, 0 a user win, 0.5 a draw.
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "mnk_board.h"
+#include "search_budget.h"
+
+using namespace std;
+
+struct mcts_node
+{
+    int parent; // index of the parent node (-1 for the root).
+    int first_child; // index of the first child (-1 if the node hasn't been expanded yet). Children are next to each other.
+    int child_count;
+    int move; // the square played to get here from the parent (-1 for the root).
+    bool moved_by_comp; // true if the computer played move.
+    int terminal_result; // -1 if the game isn't over here, otherwise 2 for a computer win, 1 for a draw, 0 for a user win.
+    int visits;
+    double total_score; // sum of playout results, from the point of view of whoever played move.
+};
+
+struct mcts_result
+{
+    int best_move = -1; // the square with the most visits (-1 if there are no moves).
+    double expected_score = 0.5; // from the point of view of the side to move, between 0 and 1.
+    long long playouts = 0;
+    double seconds = 0;
+    double playouts_per_second = 0;
+};
+
+class mcts_tree
+{
+public:
+    static const int visits_before_expanding = 4; // a node (other than the root) gets children after this many playouts.
+
+    // Constructor:
+    mcts_tree(const mnk_board& boardP, bool comp_to_moveP, bool use_puctP, unsigned long long seedP);
+
+    // Public methods:
+    void run_iteration(); // one select, expand, playout, and back up.
+    void advance(int square); // plays square on the board, and keeps only the tree under it.
+
+    // Getters:
+    const mnk_board& get_board() const;
+    bool get_comp_to_move() const;
+    int get_root_child_count() const;
+    const mcts_node& get_root_child(int i) const;
+
+private:
+    mnk_board board; // the position at the root.
+    bool comp_to_move; // true if it's the computer's turn at the root.
+    bool use_puct;
+    vector <mcts_node> nodes; // every node of the tree, with the root at index 0.
+    unsigned long long random_state; // for next_random().
+
+    // Private methods:
+    int select_child(int node) const; // returns the child to walk down to, by UCT or PUCT.
+    void expand(int node, mnk_board& node_board, bool node_comp_to_move); // adds a child for each empty square.
+    int playout(mnk_board& playout_board, bool playout_comp_to_move); // plays randomly to the end, and returns 2, 1
+                                                                      // or 0 like terminal_result.
+    unsigned long long next_random(); // xorshift, so each thread has its own random numbers without locking.
+    static mcts_node make_node(int parent, int move, bool moved_by_comp);
+};
+
+class mcts_engine
+{
+public:
+    // Constructor:
+    mcts_engine(const mnk_board& boardP, bool comp_to_moveP, int number_of_threadsP = 1, bool use_puctP = false);
+
+    // Public methods:
+    mcts_result search(const search_budget& budget); // runs until the deadline or max_nodes playouts (one of them has
+                                                     // to be set), and returns the best move found.
+    void advance(int square); // plays square, keeping what each tree already knows about the position after it.
+
+    // Getters:
+    const mnk_board& get_board() const;
+
+private:
+    vector <mcts_tree> trees; // one per thread.
+};
+
+// MCTS_TREE:
+
+inline mcts_tree::mcts_tree(const mnk_board& boardP, bool comp_to_moveP, bool use_puctP, unsigned long long seedP)
+    : board(boardP)
+{
+    comp_to_move = comp_to_moveP;
+    use_puct = use_puctP;
+    random_state = seedP * 2654435761ULL + 88172645463325252ULL; // xorshift can't start from 0.
+
+    nodes.reserve(1 << 16);
+    nodes.push_back(make_node(-1, -1, !comp_to_move));
+}
+
+inline void mcts_tree::run_iteration()
+{
+    mnk_board node_board = board; // on the stack, no allocation.
+    bool node_comp_to_move = comp_to_move;
+    int node = 0;
+
+    // 1. Selection: walk down through expanded nodes until reaching one that isn't expanded, or the game is over.
+
+    while (nodes[node].first_child != -1 && nodes[node].terminal_result == -1)
+    {
+        node = select_child(node);
+
+        node_board.make_move(nodes[node].move, node_comp_to_move);
+
+        node_comp_to_move = !node_comp_to_move;
+    }
+
+    // 2. Expansion: if the game isn't over here, and this node has had enough playouts to be worth it, add the moves
+    //    after it and walk into one of them. (Waiting keeps big boards from adding hundreds of nodes per iteration.)
+
+    if (nodes[node].terminal_result == -1 && nodes[node].first_child == -1 &&
+        (node == 0 || nodes[node].visits >= visits_before_expanding))
+    {
+        expand(node, node_board, node_comp_to_move);
+
+        if (nodes[node].child_count > 0)
+        {
+            node = select_child(node);
+
+            node_board.make_move(nodes[node].move, node_comp_to_move);
+
+            node_comp_to_move = !node_comp_to_move;
+        }
+    }
+
+    // 3. Playout (unless the game is already decided):
+
+    int result = nodes[node].terminal_result;
+
+    if (result == -1)
+    {
+        result = playout(node_board, node_comp_to_move);
+    }
+
+    // 4. Back up: each node gets credit from the point of view of whoever moved into it.
+
+    double comp_score = result / 2.0;
+
+    while (node != -1)
+    {
+        nodes[node].visits ++;
+        nodes[node].total_score += nodes[node].moved_by_comp ? comp_score : 1 - comp_score;
+
+        node = nodes[node].parent;
+    }
+}
+
+inline void mcts_tree::advance(int square)
+{
+    int kept = -1; // the root's child for square, if there is one.
+
+    for (int child = nodes[0].first_child; child != -1 && child < nodes[0].first_child + nodes[0].child_count; child++)
+    {
+        if (nodes[child].move == square)
+        {
+            kept = child;
+        }
+    }
+
+    board.make_move(square, comp_to_move);
+    comp_to_move = !comp_to_move;
+
+    vector <mcts_node> new_nodes;
+
+    new_nodes.reserve(nodes.size());
+
+    if (kept == -1)
+    {
+        new_nodes.push_back(make_node(-1, -1, !comp_to_move));
+        nodes.swap(new_nodes);
+        return;
+    }
+
+    // Copy the subtree under kept, level by level, so each node's children stay next to each other:
+
+    vector <int> old_index; // old_index[i] is where new node i was in nodes.
+
+    new_nodes.push_back(nodes[kept]);
+    new_nodes[0].parent = -1;
+    new_nodes[0].move = -1;
+    old_index.push_back(kept);
+
+    for (int i = 0; i < static_cast<int>(new_nodes.size()); i++) // new_nodes grows as the loop goes.
+    {
+        const mcts_node& old = nodes[old_index[i]];
+
+        if (old.first_child == -1)
+        {
+            continue;
+        }
+
+        new_nodes[i].first_child = new_nodes.size();
+
+        for (int child = old.first_child; child < old.first_child + old.child_count; child++)
+        {
+            new_nodes.push_back(nodes[child]);
+            new_nodes.back().parent = i;
+            old_index.push_back(child);
+        }
+    }
+
+    nodes.swap(new_nodes);
+}
+
+inline const mnk_board& mcts_tree::get_board() const
+{
+    return board;
+}
+
+inline bool mcts_tree::get_comp_to_move() const
+{
+    return comp_to_move;
+}
+
+inline int mcts_tree::get_root_child_count() const
+{
+    return nodes[0].first_child == -1 ? 0 : nodes[0].child_count;
+}
+
+inline const mcts_node& mcts_tree::get_root_child(int i) const
+{
+    return nodes[nodes[0].first_child + i];
+}
+
+inline int mcts_tree::select_child(int node) const
+{
+    const mcts_node& parent = nodes[node];
+
+    int best_child = -1;
+    double best_value = -1;
+
+    double log_visits = log(double(parent.visits + 1));
+    double sqrt_visits = sqrt(double(parent.visits + 1));
+
+    for (int child = parent.first_child; child < parent.first_child + parent.child_count; child++)
+    {
+        const mcts_node& c = nodes[child];
+
+        if (c.terminal_result != -1 && (c.moved_by_comp ? c.terminal_result == 2 : c.terminal_result == 0))
+        {
+            return child; // a move that wins on the spot is always the one to look at.
+        }
+
+        double value = 0;
+
+        if (use_puct)
+        {
+            // PUCT, with every move equally likely before any playouts (there's no policy to say otherwise):
+
+            double average = c.visits == 0 ? 0.5 : c.total_score / c.visits;
+
+            value = average + 1.5 * (1.0 / parent.child_count) * sqrt_visits / (1 + c.visits);
+        }
+
+        else
+        {
+            if (c.visits == 0)
+            {
+                return child; // UCT tries every move once before comparing them.
+            }
+
+            value = c.total_score / c.visits + 1.41 * sqrt(log_visits / c.visits);
+        }
+
+        if (value > best_value)
+        {
+            best_value = value;
+            best_child = child;
+        }
+    }
+
+    return best_child;
+}
+
+inline void mcts_tree::expand(int node, mnk_board& node_board, bool node_comp_to_move)
+{
+    if (node_board.is_full())
+    {
+        nodes[node].terminal_result = 1;
+        return;
+    }
+
+    int first = nodes.size();
+
+    for (int square = 0; square < node_board.get_number_of_squares(); square++)
+    {
+        if (!node_board.is_empty(square))
+        {
+            continue;
+        }
+
+        mcts_node child = make_node(node, square, node_comp_to_move);
+
+        node_board.make_move(square, node_comp_to_move);
+
+        if (node_board.is_win_at(square))
+        {
+            child.terminal_result = node_comp_to_move ? 2 : 0;
+        }
+
+        else if (node_board.is_full())
+        {
+            child.terminal_result = 1;
+        }
+
+        node_board.undo_move(square);
+
+        nodes.push_back(child);
+    }
+
+    nodes[node].first_child = first;
+    nodes[node].child_count = nodes.size() - first;
+}
+
+inline int mcts_tree::playout(mnk_board& playout_board, bool playout_comp_to_move)
+{
+    int empty_squares[mnk_board::max_squares];
+    int number_of_empty_squares = 0;
+
+    for (int square = 0; square < playout_board.get_number_of_squares(); square++)
+    {
+        if (playout_board.is_empty(square))
+        {
+            empty_squares[number_of_empty_squares++] = square;
+        }
+    }
+
+    while (number_of_empty_squares > 0)
+    {
+        // Pick a random empty square, and fill its spot in the array with the last one:
+
+        int index = next_random() % number_of_empty_squares;
+        int square = empty_squares[index];
+
+        empty_squares[index] = empty_squares[--number_of_empty_squares];
+
+        playout_board.make_move(square, playout_comp_to_move);
+
+        if (playout_board.is_win_at(square))
+        {
+            return playout_comp_to_move ? 2 : 0;
+        }
+
+        playout_comp_to_move = !playout_comp_to_move;
+    }
+
+    return 1;
+}
+
+inline unsigned long long mcts_tree::next_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+
+    return random_state;
+}
+
+inline mcts_node mcts_tree::make_node(int parent, int move, bool moved_by_comp)
+{
+    mcts_node node;
+
+    node.parent = parent;
+    node.first_child = -1;
+    node.child_count = 0;
+    node.move = move;
+    node.moved_by_comp = moved_by_comp;
+    node.terminal_result = -1;
+    node.visits = 0;
+    node.total_score = 0;
+
+    return node;
+}
+
+// MCTS_ENGINE:
+
+inline mcts_engine::mcts_engine(const mnk_board& boardP, bool comp_to_moveP, int number_of_threadsP, bool use_puctP)
+{
+    if (number_of_threadsP < 1)
+    {
+        number_of_threadsP = 1;
+    }
+
+    for (int i = 0; i < number_of_threadsP; i++)
+    {
+        trees.push_back(mcts_tree(boardP, comp_to_moveP, use_puctP, i + 1));
+    }
+}
+
+inline mcts_result mcts_engine::search(const search_budget& budget)
+{
+    mcts_result result;
+
+    atomic<long long> playouts(0);
+
+    chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+
+    // Each thread works on its own tree, so the only thing they share is the playout count:
+
+    auto grow = [&](mcts_tree& tree)
+    {
+        while (true)
+        {
+            // Checking the clock is slow compared to an iteration on a small board, so only do it every so often:
+
+            for (int i = 0; i < 64; i++)
+            {
+                if (budget.max_nodes != 0 && playouts++ >= budget.max_nodes)
+                {
+                    return;
+                }
+
+                tree.run_iteration();
+            }
+
+            if (budget.max_nodes == 0)
+            {
+                playouts += 64;
+            }
+
+            if (chrono::steady_clock::now() >= budget.deadline)
+            {
+                return;
+            }
+        }
+    };
+
+    vector <thread> threads;
+
+    for (size_t i = 1; i < trees.size(); i++)
+    {
+        threads.push_back(thread(grow, ref(trees[i])));
+    }
+
+    grow(trees[0]); // the calling thread grows the first tree itself.
+
+    for (thread& t: threads)
+    {
+        t.join();
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+    result.playouts = budget.max_nodes != 0 ? min(playouts.load(), budget.max_nodes) : playouts.load();
+    result.playouts_per_second = result.seconds > 0 ? result.playouts / result.seconds : 0;
+
+    // Add up the visits (and scores) for each first move over all the trees. Every tree adds its root's children in
+    // the same order (by square), so child i is the same move in every tree (if that tree got far enough to add it).
+
+    const mcts_tree* expanded_tree = &trees[0];
+
+    for (const mcts_tree& tree: trees)
+    {
+        if (tree.get_root_child_count() > expanded_tree->get_root_child_count())
+        {
+            expanded_tree = &tree;
+        }
+    }
+
+    int best_visits = -1;
+
+    for (int i = 0; i < expanded_tree->get_root_child_count(); i++)
+    {
+        int visits = 0;
+        double total_score = 0;
+
+        for (const mcts_tree& tree: trees)
+        {
+            if (i < tree.get_root_child_count())
+            {
+                visits += tree.get_root_child(i).visits;
+                total_score += tree.get_root_child(i).total_score;
+            }
+        }
+
+        if (visits > best_visits)
+        {
+            best_visits = visits;
+            result.best_move = expanded_tree->get_root_child(i).move;
+            result.expected_score = visits > 0 ? total_score / visits : 0.5;
+        }
+    }
+
+    return result;
+}
+
+inline void mcts_engine::advance(int square)
+{
+    for (mcts_tree& tree: trees)
+    {
+        tree.advance(square);
+    }
+}
+
+inline const mnk_board& mcts_engine::get_board() const
+{
+    return trees[0].get_board();
+}
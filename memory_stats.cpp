@@ -0,0 +1,228 @@
+#include "memory_stats.h"
+
+// Initializing the static variables:
+
+thread_local memory_category memory_stats::current_category = memory_other;
+
+atomic<long long> memory_stats::live_bytes[number_of_memory_categories];
+atomic<long long> memory_stats::search_peak_bytes[number_of_memory_categories];
+atomic<long long> memory_stats::game_peak_bytes[number_of_memory_categories];
+atomic<long long> memory_stats::total_live_bytes(0);
+atomic<long long> memory_stats::total_search_peak_bytes(0);
+atomic<long long> memory_stats::total_game_peak_bytes(0);
+
+// MEMORY_STATS:
+
+bool memory_stats::is_enabled()
+{
+#ifdef MEMORY_ACCOUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void memory_stats::begin_search()
+{
+    for (int c = 0; c < number_of_memory_categories; c++)
+    {
+        search_peak_bytes[c] = live_bytes[c].load();
+    }
+
+    total_search_peak_bytes = total_live_bytes.load();
+}
+
+void memory_stats::begin_game()
+{
+    for (int c = 0; c < number_of_memory_categories; c++)
+    {
+        game_peak_bytes[c] = live_bytes[c].load();
+    }
+
+    total_game_peak_bytes = total_live_bytes.load();
+}
+
+long long memory_stats::get_live_bytes(memory_category c)
+{
+    return live_bytes[c];
+}
+
+long long memory_stats::get_search_peak_bytes(memory_category c)
+{
+    return search_peak_bytes[c];
+}
+
+long long memory_stats::get_game_peak_bytes(memory_category c)
+{
+    return game_peak_bytes[c];
+}
+
+long long memory_stats::get_live_bytes()
+{
+    return total_live_bytes;
+}
+
+long long memory_stats::get_search_peak_bytes()
+{
+    return total_search_peak_bytes;
+}
+
+long long memory_stats::get_game_peak_bytes()
+{
+    return total_game_peak_bytes;
+}
+
+string memory_stats::get_category_name(memory_category c)
+{
+    switch (c)
+    {
+        case memory_nodes: return "nodes";
+        case memory_boards: return "boards";
+        case memory_child_vectors: return "child vectors";
+        case memory_cache: return "cache";
+        default: return "other";
+    }
+}
+
+void memory_stats::print_search_report(ostream& out)
+{
+    if (!is_enabled())
+    {
+        out << "Memory accounting is off (build with -DMEMORY_ACCOUNTING to turn it on).\n";
+        return;
+    }
+
+    for (int c = 0; c < number_of_memory_categories; c++)
+    {
+        memory_category category = static_cast<memory_category>(c);
+
+        out << get_category_name(category) << ": " << get_live_bytes(category) << " bytes live, "
+            << get_search_peak_bytes(category) << " bytes peak\n";
+    }
+
+    out << "total: " << get_live_bytes() << " bytes live, " << get_search_peak_bytes() << " bytes peak\n";
+}
+
+void memory_stats::record_allocation(memory_category c, long long bytes)
+{
+    raise_to(search_peak_bytes[c], live_bytes[c] += bytes);
+    raise_to(game_peak_bytes[c], live_bytes[c]);
+
+    long long total = (total_live_bytes += bytes);
+
+    raise_to(total_search_peak_bytes, total);
+    raise_to(total_game_peak_bytes, total);
+}
+
+void memory_stats::record_deallocation(memory_category c, long long bytes)
+{
+    live_bytes[c] -= bytes;
+    total_live_bytes -= bytes;
+}
+
+void memory_stats::raise_to(atomic<long long>& peak, long long value)
+{
+    long long current = peak;
+
+    while (value > current && !peak.compare_exchange_weak(current, value))
+    {
+        // compare_exchange_weak put the latest peak into current, so just try again.
+    }
+}
+
+#ifdef MEMORY_ACCOUNTING
+
+// The replacement operator new puts a small header in front of every block, holding its size and category, so that
+// operator delete knows what to take off the counts. The header is 16 bytes so the block stays suitably aligned.
+
+struct memory_block_header
+{
+    long long bytes;
+    memory_category category;
+};
+
+static_assert(sizeof(memory_block_header) <= 16, "memory_block_header has to fit in 16 bytes");
+
+void* operator new(size_t bytes)
+{
+    char* block = static_cast<char*>(malloc(bytes + 16));
+
+    if (block == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    memory_block_header* header = reinterpret_cast<memory_block_header*>(block);
+
+    header->bytes = bytes;
+    header->category = memory_stats::current_category;
+
+    memory_stats::record_allocation(header->category, bytes);
+
+    return block + 16;
+}
+
+void* operator new[](size_t bytes)
+{
+    return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(bytes);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t bytes, const nothrow_t&) noexcept
+{
+    return operator new(bytes, nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+
+    char* block = static_cast<char*>(pointer) - 16;
+
+    memory_block_header* header = reinterpret_cast<memory_block_header*>(block);
+
+    memory_stats::record_deallocation(header->category, header->bytes);
+
+    free(block);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif
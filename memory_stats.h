@@ -0,0 +1,96 @@
+/* "memory_stats" counts every byte the program takes from the heap, split up by what it's used for.
+
+    - Only switched on when MEMORY_ACCOUNTING is defined (e.g. -DMEMORY_ACCOUNTING). Then, the global operator new and
+      operator delete are replaced by versions that count bytes. Otherwise, nothing in here costs anything and all the
+      numbers stay at 0: memory_scope's constructor and destructor are inline, and empty, so the compiler drops them.
+      It should be defined for every file in the build (memory_stats.cpp and position.cpp included), so every scope is
+      counted. memory_scope has the same members either way, so its layout never depends on it.
+    - Each allocation is charged to a memory_category. The category is whatever the innermost memory_scope on that
+      thread says it is (memory_other if there isn't one).
+    - Live bytes are what's allocated right now. Peak bytes are the most that was live at once since the last
+      begin_search() (for a search) or begin_game() (for a game).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+enum memory_category
+{
+    memory_nodes, // position objects themselves.
+    memory_boards, // the vector <vector<char>> inside each position, and copies of it.
+    memory_child_vectors, // the future_positions vectors.
+    memory_cache, // caches and tables built to speed up searching.
+    memory_other, // everything else.
+    number_of_memory_categories
+};
+
+class memory_stats
+{
+public:
+    // Public static methods:
+    static bool is_enabled(); // returns true if the program was built with MEMORY_ACCOUNTING.
+    static void begin_search(); // starts measuring a new search's peak from the bytes live right now.
+    static void begin_game(); // starts measuring a new game's peak (its high-water mark) from the bytes live right now.
+    static long long get_live_bytes(memory_category c);
+    static long long get_search_peak_bytes(memory_category c);
+    static long long get_game_peak_bytes(memory_category c);
+    static long long get_live_bytes(); // all categories together.
+    static long long get_search_peak_bytes(); // all categories together (not the sum of the category peaks!).
+    static long long get_game_peak_bytes(); // all categories together.
+    static string get_category_name(memory_category c);
+    static void print_search_report(ostream& out); // prints live and peak bytes for each category.
+
+    static void record_allocation(memory_category c, long long bytes); // only called by operator new & delete.
+    static void record_deallocation(memory_category c, long long bytes);
+
+    // Public static variable(s):
+    static thread_local memory_category current_category; // what new allocations on this thread are charged to.
+
+private:
+    static atomic<long long> live_bytes[number_of_memory_categories];
+    static atomic<long long> search_peak_bytes[number_of_memory_categories];
+    static atomic<long long> game_peak_bytes[number_of_memory_categories];
+    static atomic<long long> total_live_bytes;
+    static atomic<long long> total_search_peak_bytes;
+    static atomic<long long> total_game_peak_bytes;
+
+    // Private static methods:
+    static void raise_to(atomic<long long>& peak, long long value); // sets peak to value, if value is bigger.
+};
+
+class memory_scope
+{
+public:
+    // Constructor & destructor:
+    memory_scope(memory_category c); // allocations on this thread are charged to c...
+    ~memory_scope(); // ...until this scope ends, when the previous category comes back.
+
+private:
+    memory_category previous_category; // only used with MEMORY_ACCOUNTING, but always here (see the top of the file).
+};
+
+// MEMORY_SCOPE (inline, since one is opened on every position created):
+
+inline memory_scope::memory_scope(memory_category c)
+{
+#ifdef MEMORY_ACCOUNTING
+    previous_category = memory_stats::current_category;
+    memory_stats::current_category = c;
+#else
+    (void) c;
+#endif
+}
+
+inline memory_scope::~memory_scope()
+{
+#ifdef MEMORY_ACCOUNTING
+    memory_stats::current_category = previous_category;
+#endif
+}
@@ -0,0 +1,213 @@
+/* An "mnk_board" is a board of any size up to 16x16, where the goal is k pieces in a row (so 3x3 with k = 3 is normal
+   tic-tac-toe, and 15x15 with k = 5 is gomoku).
+
+    - Squares are numbered row by row: square = row * cols + col.
+    - Each side's pieces are kept as a bitset in 4 unsigned 64-bit words, so copying a board never touches the heap.
+      That makes it cheap to copy a board and play random moves on the copy (e.g. for Monte Carlo playouts).
+    - Only the move just made can create a new k-in-a-row, so is_win_at() only looks at the lines through that square.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+class mnk_board
+{
+public:
+    static const int max_squares = 256; // 16x16.
+
+    // Constructor:
+    mnk_board(int rowsP, int colsP, int kP); // an empty board. Throws if it's bigger than 16x16 or k doesn't fit.
+
+    // Getters:
+    int get_rows() const;
+    int get_cols() const;
+    int get_k() const;
+    int get_number_of_squares() const;
+    int get_number_of_pieces() const;
+    char get_square(int square) const; // returns 'C', 'U' or ' '.
+
+    // Public methods:
+    bool is_empty(int square) const;
+    bool is_full() const;
+    void make_move(int square, bool is_comp); // puts the computer's (or user's) piece on square.
+    void undo_move(int square); // takes the piece off square.
+    bool is_win_at(int square) const; // returns true if the piece on square is part of k (or more) in a row.
+    int count_in_direction(int square, int row_step, int col_step) const; // returns how many pieces of the same side
+                                                                          // as the piece on square are next to it in
+                                                                          // a line, going in one direction (not
+                                                                          // counting square itself).
+
+private:
+    int rows;
+    int cols;
+    int k;
+    int number_of_pieces;
+    uint64_t comp_bits[4]; // bit i of the 256 is set if the computer has a piece on square i.
+    uint64_t user_bits[4]; // bit i of the 256 is set if the user has a piece on square i.
+
+    // Private methods:
+    bool has_comp_piece(int square) const;
+    bool has_user_piece(int square) const;
+};
+
+// CONSTRUCTOR:
+
+inline mnk_board::mnk_board(int rowsP, int colsP, int kP)
+{
+    if (rowsP < 1 || colsP < 1 || rowsP * colsP > max_squares || rowsP > 16 || colsP > 16)
+    {
+        throw invalid_argument("mnk_board: the board has to be between 1x1 and 16x16.");
+    }
+
+    if (kP < 1 || (kP > rowsP && kP > colsP))
+    {
+        throw invalid_argument("mnk_board: k has to fit on the board.");
+    }
+
+    rows = rowsP;
+    cols = colsP;
+    k = kP;
+    number_of_pieces = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        comp_bits[i] = 0;
+        user_bits[i] = 0;
+    }
+}
+
+// GETTERS:
+
+inline int mnk_board::get_rows() const
+{
+    return rows;
+}
+
+inline int mnk_board::get_cols() const
+{
+    return cols;
+}
+
+inline int mnk_board::get_k() const
+{
+    return k;
+}
+
+inline int mnk_board::get_number_of_squares() const
+{
+    return rows * cols;
+}
+
+inline int mnk_board::get_number_of_pieces() const
+{
+    return number_of_pieces;
+}
+
+inline char mnk_board::get_square(int square) const
+{
+    if (has_comp_piece(square))
+    {
+        return 'C';
+    }
+
+    if (has_user_piece(square))
+    {
+        return 'U';
+    }
+
+    return ' ';
+}
+
+// PUBLIC METHODS:
+
+inline bool mnk_board::is_empty(int square) const
+{
+    return !has_comp_piece(square) && !has_user_piece(square);
+}
+
+inline bool mnk_board::is_full() const
+{
+    return number_of_pieces == rows * cols;
+}
+
+inline void mnk_board::make_move(int square, bool is_comp)
+{
+    if (is_comp)
+    {
+        comp_bits[square >> 6] |= uint64_t(1) << (square & 63);
+    }
+
+    else
+    {
+        user_bits[square >> 6] |= uint64_t(1) << (square & 63);
+    }
+
+    number_of_pieces ++;
+}
+
+inline void mnk_board::undo_move(int square)
+{
+    comp_bits[square >> 6] &= ~(uint64_t(1) << (square & 63));
+    user_bits[square >> 6] &= ~(uint64_t(1) << (square & 63));
+
+    number_of_pieces --;
+}
+
+inline bool mnk_board::is_win_at(int square) const
+{
+    // The four lines through a square: horizontal, vertical, and the two diagonals.
+
+    const int steps[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+    for (const auto& step: steps)
+    {
+        int in_a_row = 1 + count_in_direction(square, step[0], step[1]) + count_in_direction(square, -step[0], -step[1]);
+
+        if (in_a_row >= k)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline int mnk_board::count_in_direction(int square, int row_step, int col_step) const
+{
+    bool is_comp = has_comp_piece(square);
+    int row = square / cols + row_step;
+    int col = square % cols + col_step;
+    int count = 0;
+
+    while (row >= 0 && row < rows && col >= 0 && col < cols && count < k)
+    {
+        int next = row * cols + col;
+
+        if (is_comp ? !has_comp_piece(next) : !has_user_piece(next))
+        {
+            break;
+        }
+
+        count ++;
+        row += row_step;
+        col += col_step;
+    }
+
+    return count;
+}
+
+// PRIVATE METHODS:
+
+inline bool mnk_board::has_comp_piece(int square) const
+{
+    return (comp_bits[square >> 6] >> (square & 63)) & 1;
+}
+
+inline bool mnk_board::has_user_piece(int square) const
+{
+    return (user_bits[square >> 6] >> (square & 63)) & 1;
+}
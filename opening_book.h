@@ -0,0 +1,256 @@
+/* An "opening_book" knows the best moves for the first few moves of a game, so they can be played right away instead
+   of being searched. The searches at depth 0 and 1 are the biggest ones in a game (they go through almost the whole
+   game tree), and every new game used to repeat them.
+
+    - Built from solved data: every position with at most max_pieces pieces (and the game not over yet) is solved
+      with a variant_solver<standard_rules>, and stored with its evaluation and its best moves.
+    - Each best move has a weight: 1, plus how many of the other side's replies to it would be mistakes. So among
+      equally good moves, the ones that give the other side more ways to go wrong are played more often.
+    - pick_move() chooses one of the best moves at random, in proportion to the weights. This is where the variety
+      between games comes from (instead of shuffling position::coordinates at the start of each game).
+    - Evaluations are from the computer's point of view, like in position: 1, 0 or -1.
+    - Looking a position up is two array reads: its position_index rank (and whose turn it is) gives where its entry
+      is kept, if it has one.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdlib>
+
+#include "position.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "position_index.h"
+#include "memory_stats.h"
+
+using namespace std;
+
+struct book_move
+{
+    coordinate square;
+    int weight;
+};
+
+struct book_entry
+{
+    int evaluation; // from the computer's point of view.
+    vector<book_move> moves; // only the best moves for the side to move.
+    int total_weight;
+};
+
+class opening_book
+{
+public:
+    // Constructor:
+    opening_book(int max_piecesP = 2); // solves and stores every position with up to max_piecesP pieces.
+
+    // Public methods:
+    const book_entry* find(const vector <vector<char>>& board, bool is_comp_turn) const; // returns nullptr if board
+                                                                                        // isn't in the book.
+    bool pick_move(const vector <vector<char>>& board, bool is_comp_turn, coordinate& square) const; // weighted random
+                                                                                                    // choice (using
+                                                                                                    // rand()). Returns
+                                                                                                    // false if board
+                                                                                                    // isn't in the book.
+    unique_ptr<position> create_position(const vector <vector<char>>& board, bool is_comp_turn) const; // a position
+                                                                                                      // with the book's
+                                                                                                      // evaluation, and
+                                                                                                      // no search. nullptr
+                                                                                                      // if board isn't in
+                                                                                                      // the book.
+
+    // Getters:
+    int get_max_pieces() const;
+    int get_number_of_positions() const;
+
+private:
+    int max_pieces;
+    vector<book_entry> entries;
+    vector<short> entry_numbers; // by rank * 2 + is_comp_turn: the index of the position's entry (-1 if it has none).
+
+    // Private methods:
+    void add_positions(const standard_rules::state& s, variant_solver<standard_rules>& solver); // adds s, and every
+                                                                                               // position after it
+                                                                                               // with up to
+                                                                                               // max_pieces pieces.
+};
+
+// CONSTRUCTOR:
+
+inline opening_book::opening_book(int max_piecesP)
+{
+    max_pieces = max_piecesP;
+
+    memory_scope scope(memory_cache);
+
+    entry_numbers.assign(2 * position_index::number_of_positions, -1);
+
+    variant_solver<standard_rules> solver;
+
+    add_positions(standard_rules::start_state(true), solver);
+    add_positions(standard_rules::start_state(false), solver);
+}
+
+// PUBLIC METHODS:
+
+inline const book_entry* opening_book::find(const vector <vector<char>>& board, bool is_comp_turn) const
+{
+    unsigned int code = bitboard::encode(board);
+
+    if (!position_index::is_rankable(code))
+    {
+        return nullptr;
+    }
+
+    int entry_number = entry_numbers[position_index::get_rank(code) * 2 + is_comp_turn];
+
+    return (entry_number == -1) ? nullptr : &entries[entry_number];
+}
+
+inline bool opening_book::pick_move(const vector <vector<char>>& board, bool is_comp_turn, coordinate& square) const
+{
+    const book_entry* entry = find(board, is_comp_turn);
+
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    int chosen = rand() % entry->total_weight;
+
+    for (const book_move& m: entry->moves)
+    {
+        chosen -= m.weight;
+
+        if (chosen < 0)
+        {
+            square = m.square;
+            return true;
+        }
+    }
+
+    return false; // only if the weights don't add up to total_weight, which add_positions() doesn't let happen.
+}
+
+inline unique_ptr<position> opening_book::create_position(const vector <vector<char>>& board, bool is_comp_turn) const
+{
+    const book_entry* entry = find(board, is_comp_turn);
+
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+
+    int depth = bitboard::count_pieces(bitboard::encode(board));
+
+    return position::with_evaluation(board, is_comp_turn, depth, entry->evaluation);
+}
+
+// GETTERS:
+
+inline int opening_book::get_max_pieces() const
+{
+    return max_pieces;
+}
+
+inline int opening_book::get_number_of_positions() const
+{
+    return entries.size();
+}
+
+// PRIVATE METHODS:
+
+inline void opening_book::add_positions(const standard_rules::state& s, variant_solver<standard_rules>& solver)
+{
+    int index = position_index::get_rank(s.code) * 2 + s.comp_to_move;
+
+    if (bitboard::count_pieces(s.code) > max_pieces || entry_numbers[index] != -1)
+    {
+        return;
+    }
+
+    int value = solver.solve(s); // for the side to move.
+
+    book_entry entry;
+
+    entry.evaluation = s.comp_to_move ? value : -value;
+    entry.total_weight = 0;
+
+    int moves[standard_rules::max_moves];
+    int count = standard_rules::generate_moves(s, moves);
+
+    for (int i = 0; i < count; i++)
+    {
+        standard_rules::state next = standard_rules::apply_move(s, moves[i]);
+        bool game_over;
+        int next_value = standard_rules::get_value(next, game_over); // for the other side, like solve() below.
+
+        if (!game_over)
+        {
+            next_value = solver.solve(next);
+        }
+
+        if (-next_value != value) // not one of the best moves.
+        {
+            continue;
+        }
+
+        // Count the other side's replies that do worse than its best:
+
+        int weight = 1;
+
+        if (!game_over)
+        {
+            int replies[standard_rules::max_moves];
+            int reply_count = standard_rules::generate_moves(next, replies);
+
+            for (int j = 0; j < reply_count; j++)
+            {
+                standard_rules::state after = standard_rules::apply_move(next, replies[j]);
+                bool reply_over;
+                int after_value = standard_rules::get_value(after, reply_over);
+
+                if (!reply_over)
+                {
+                    after_value = solver.solve(after);
+                }
+
+                if (-after_value < next_value)
+                {
+                    weight ++;
+                }
+            }
+        }
+
+        book_move m;
+
+        m.square.row = moves[i] / 3;
+        m.square.col = moves[i] % 3;
+        m.weight = weight;
+
+        entry.moves.push_back(m);
+        entry.total_weight += weight;
+    }
+
+    memory_scope scope(memory_cache);
+
+    entry_numbers[index] = entries.size();
+    entries.push_back(entry);
+
+    // The other side's mistakes can be played too, so their positions need to be in the book as well:
+
+    for (int i = 0; i < count; i++)
+    {
+        standard_rules::state next = standard_rules::apply_move(s, moves[i]);
+        bool game_over;
+
+        standard_rules::get_value(next, game_over);
+
+        if (!game_over)
+        {
+            add_positions(next, solver);
+        }
+    }
+}
@@ -0,0 +1,270 @@
+/* "perft" counts every position a given number of moves ahead, without evaluating or pruning anything. It's for
+   checking (and timing) the basic pieces a search is built from - generating moves, making and unmaking them, and
+   seeing if a game is over - on their own, apart from the search.
+
+    - A walk stops at a position if it's depth moves ahead of the start, or if the game is over there. Those
+      positions are the "leaves", and the ones where the game is over are also counted as a computer win, a user win
+      or a draw.
+    - Boards are bitboards, and a move is made and unmade by flipping one bit, so the walk never touches the heap.
+    - divide() gives the counts under each root move separately, which is how a wrong total is narrowed down to the
+      move that causes it.
+    - run_parallel() gives each thread some of the root moves, then adds up what they found.
+
+   From the empty board with the computer going first, perft to depth 9 should find every possible game: 255168 leaves,
+   of which 131184 are computer wins, 77904 are user wins and 46080 are draws.
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <ostream>
+
+#include "position.h"
+#include "bitboard.h"
+
+using namespace std;
+
+struct perft_counts
+{
+    long long nodes = 0; // every position visited, including the start.
+    long long leaves = 0;
+    long long comp_wins = 0;
+    long long user_wins = 0;
+    long long draws = 0;
+    double seconds = 0;
+    double nodes_per_second = 0;
+};
+
+struct perft_divide_entry
+{
+    coordinate move;
+    perft_counts counts;
+};
+
+class perft
+{
+public:
+    // Public static methods:
+    static perft_counts run(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth);
+    static vector<perft_divide_entry> divide(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth);
+    static perft_counts run_parallel(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth,
+                                     int threads); // threads below 1 means one per hardware thread.
+    static void print_divide(ostream& out, const vector<perft_divide_entry>& entries); // one line per root move, then
+                                                                                        // the totals.
+
+private:
+    // Private static methods:
+    static void walk(unsigned int& code, bool is_comp_turn, int depth, perft_counts& counts); // code is changed while
+                                                                                               // walking, but is back
+                                                                                               // to how it was when
+                                                                                               // this returns.
+    static void add_counts(perft_counts& total, const perft_counts& more);
+    static void set_rate(perft_counts& counts, chrono::steady_clock::time_point start);
+};
+
+// PUBLIC STATIC METHODS:
+
+inline perft_counts perft::run(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    perft_counts counts;
+    unsigned int code = bitboard::encode(boardP);
+
+    walk(code, is_comp_turnP, depth, counts);
+
+    set_rate(counts, start);
+
+    return counts;
+}
+
+inline vector<perft_divide_entry> perft::divide(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth)
+{
+    vector<perft_divide_entry> entries;
+
+    unsigned int code = bitboard::encode(boardP);
+    int shift = is_comp_turnP ? 0 : 9; // where the piece of the side to move goes in the bitboard.
+
+    for (int square = 0; square < 9 && depth > 0; square++)
+    {
+        if (!(bitboard::get_empty_squares(code) & (1u << square)))
+        {
+            continue;
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        perft_divide_entry entry;
+
+        entry.move.row = square / 3;
+        entry.move.col = square % 3;
+
+        code ^= 1u << (shift + square);
+        walk(code, !is_comp_turnP, depth - 1, entry.counts);
+        code ^= 1u << (shift + square);
+
+        set_rate(entry.counts, start);
+
+        entries.push_back(entry);
+    }
+
+    return entries;
+}
+
+inline perft_counts perft::run_parallel(const vector <vector<char>>& boardP, bool is_comp_turnP, int depth, int threads)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (threads < 1)
+    {
+        threads = thread::hardware_concurrency(); // can be 0 if it isn't known, hence the check below.
+    }
+
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    unsigned int root_code = bitboard::encode(boardP);
+    int shift = is_comp_turnP ? 0 : 9;
+
+    vector<int> root_moves;
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (bitboard::get_empty_squares(root_code) & (1u << square))
+        {
+            root_moves.push_back(square);
+        }
+    }
+
+    // If the walk doesn't go past the root (or the game is already over there), there's nothing to split up:
+
+    perft_counts root_only;
+    unsigned int code = root_code;
+
+    walk(code, is_comp_turnP, 0, root_only);
+
+    if (depth == 0 || root_only.comp_wins + root_only.user_wins + root_only.draws != 0)
+    {
+        return run(boardP, is_comp_turnP, depth);
+    }
+
+    // Thread t takes root moves t, t + threads, t + 2 * threads, and so on:
+
+    vector<perft_counts> thread_counts(threads);
+    vector<thread> workers;
+    int number_of_root_moves = root_moves.size();
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            for (int i = t; i < number_of_root_moves; i += threads)
+            {
+                unsigned int thread_code = root_code | (1u << (shift + root_moves[i]));
+
+                walk(thread_code, !is_comp_turnP, depth - 1, thread_counts[t]);
+            }
+        });
+    }
+
+    perft_counts total;
+
+    total.nodes = 1; // the root itself.
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t].join();
+        add_counts(total, thread_counts[t]);
+    }
+
+    set_rate(total, start);
+
+    return total;
+}
+
+inline void perft::print_divide(ostream& out, const vector<perft_divide_entry>& entries)
+{
+    perft_counts total;
+
+    total.nodes = 1; // the root itself.
+
+    for (const perft_divide_entry& entry: entries)
+    {
+        out << char('a' + entry.move.col) << (entry.move.row + 1) << ": " << entry.counts.leaves << " leaves ("
+            << entry.counts.comp_wins << " computer wins, " << entry.counts.user_wins << " user wins, "
+            << entry.counts.draws << " draws)\n";
+
+        add_counts(total, entry.counts);
+    }
+
+    out << "Total: " << total.leaves << " leaves, " << total.nodes << " nodes\n";
+}
+
+// PRIVATE STATIC METHODS:
+
+inline void perft::walk(unsigned int& code, bool is_comp_turn, int depth, perft_counts& counts)
+{
+    counts.nodes ++;
+
+    // Same rules as position::did_computer_win() and did_opponent_win(): only the side that just moved can have won.
+
+    if (!is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_comp_pieces(code)))
+    {
+        counts.leaves ++;
+        counts.comp_wins ++;
+        return;
+    }
+
+    if (is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_user_pieces(code)))
+    {
+        counts.leaves ++;
+        counts.user_wins ++;
+        return;
+    }
+
+    unsigned int empty = bitboard::get_empty_squares(code);
+
+    if (empty == 0)
+    {
+        counts.leaves ++;
+        counts.draws ++;
+        return;
+    }
+
+    if (depth == 0)
+    {
+        counts.leaves ++;
+        return;
+    }
+
+    int shift = is_comp_turn ? 0 : 9;
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (empty & (1u << square))
+        {
+            code ^= 1u << (shift + square); // make the move.
+            walk(code, !is_comp_turn, depth - 1, counts);
+            code ^= 1u << (shift + square); // unmake it.
+        }
+    }
+}
+
+inline void perft::add_counts(perft_counts& total, const perft_counts& more)
+{
+    total.nodes += more.nodes;
+    total.leaves += more.leaves;
+    total.comp_wins += more.comp_wins;
+    total.user_wins += more.user_wins;
+    total.draws += more.draws;
+}
+
+inline void perft::set_rate(perft_counts& counts, chrono::steady_clock::time_point start)
+{
+    counts.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    counts.nodes_per_second = (counts.seconds > 0) ? counts.nodes / counts.seconds : 0;
+}
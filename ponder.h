@@ -0,0 +1,172 @@
+/* A "ponderer" lets the computer think on the user's time.
+
+    - As soon as it's the user's turn, start() begins searching every reply the user could make, on a background thread.
+    - When the user's move arrives, take() stops the background thread and hands back the already searched position
+      for that move (if it got that far), so the computer doesn't need to search it again.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "position.h"
+
+using namespace std;
+
+class ponderer
+{
+public:
+    // Constructor & destructor:
+    ponderer();
+    ~ponderer(); // stops the background thread, if it's still running.
+
+    // Public methods:
+    void start(const vector <vector<char>>& boardP, int depthP); // boardP is the position where the user is to move,
+                                                                 // and depthP is its depth. Starts searching all of
+                                                                 // the user's replies in the background.
+
+    unique_ptr<position> take(int row, int col); // stops pondering, and returns the position after the user puts a
+                                                 // piece on [row][col]. Returns nullptr if that reply wasn't searched
+                                                 // in time, in which case the caller has to search it itself.
+
+    void stop(); // stops pondering and throws away whatever was found.
+
+private:
+    thread worker; // the background thread doing the searching.
+    mutex state_mutex; // guards searching_index, stop_requested and results.
+    atomic<bool> cancel_current; // set to true to make the search in progress give up (see position::stop_signal).
+    bool stop_requested; // stores true once no more replies should be started.
+    int searching_index; // stores row * 3 + col of the reply being searched right now, or -1 if none is.
+    vector <unique_ptr<position>> results; // stores the searched position for each reply, at index row * 3 + col.
+
+    // Private methods:
+    void search_replies(vector <vector<char>> boardP, int depthP); // runs on the worker thread.
+};
+
+// CONSTRUCTOR & DESTRUCTOR:
+
+inline ponderer::ponderer()
+{
+    cancel_current = false;
+    stop_requested = false;
+    searching_index = -1;
+}
+
+inline ponderer::~ponderer()
+{
+    stop();
+}
+
+// PUBLIC METHODS:
+
+inline void ponderer::start(const vector <vector<char>>& boardP, int depthP)
+{
+    stop(); // in case the last pondering session was never taken.
+
+    cancel_current = false;
+    stop_requested = false;
+    searching_index = -1;
+
+    results.clear();
+    results.resize(9);
+
+    worker = thread(&ponderer::search_replies, this, boardP, depthP);
+}
+
+inline unique_ptr<position> ponderer::take(int row, int col)
+{
+    int wanted = row * 3 + col;
+
+    {
+        lock_guard<mutex> lock(state_mutex);
+
+        stop_requested = true;
+
+        if (searching_index != wanted) // the search in progress (if any) is for a move the user didn't play, so kill it.
+        {
+            cancel_current = true;
+        }
+    }
+
+    // If the reply being searched right now IS the user's move, this waits for it to finish instead of throwing it away:
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    if (results.size() != 9)
+    {
+        return nullptr; // start() was never called.
+    }
+
+    return move(results[wanted]);
+}
+
+inline void ponderer::stop()
+{
+    {
+        lock_guard<mutex> lock(state_mutex);
+
+        stop_requested = true;
+        cancel_current = true;
+    }
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    results.clear();
+}
+
+// PRIVATE METHODS:
+
+inline void ponderer::search_replies(vector <vector<char>> boardP, int depthP)
+{
+    position::stop_signal = &cancel_current; // so that take() and stop() can cut off a search part of the way through.
+
+    for (const coordinate& temp: position::coordinates)
+    {
+        if (boardP[temp.row][temp.col] != ' ')
+        {
+            continue;
+        }
+
+        int index = temp.row * 3 + temp.col;
+
+        {
+            lock_guard<mutex> lock(state_mutex);
+
+            if (stop_requested)
+            {
+                break;
+            }
+
+            searching_index = index;
+        }
+
+        vector <vector<char>> copy_board = boardP;
+
+        copy_board[temp.row][temp.col] = 'U';
+
+        // Searched with no alpha or beta, and lazy, exactly like play_game() would search it after the user's move:
+
+        unique_ptr<position> pt = make_unique<position>(copy_board, true, depthP + 1, 100000, 100000, true);
+
+        lock_guard<mutex> lock(state_mutex);
+
+        if (!cancel_current) // pt was searched all the way through, so it can be used.
+        {
+            results[index] = move(pt);
+        }
+
+        searching_index = -1;
+    }
+
+    position::stop_signal = nullptr;
+}
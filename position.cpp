@@ -0,0 +1,589 @@
+#include "position.h"
+
+// Initializing the static variable: coordinates
+
+const vector<coordinate> position::coordinates = create_vector_of_coordinate_objects();
+// It will be equal to a vector of coordinate objects, in the order moves are searched.
+
+atomic<int> position::number_of_instances(0);
+
+thread_local const atomic<bool>* position::stop_signal = nullptr;
+
+// CONSTRUCTORS:
+
+position::position()
+{
+    memory_scope scope(memory_boards); // outside of minimax(), which keeps its own accounts, board is all that's allocated.
+
+    // Make an empty board:
+
+    vector <char> column;
+
+    for (int i = 0; i < 3; i++)
+    {
+        column.push_back(' ');
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        board.push_back(column);
+    }
+
+    is_comp_turn = true;
+
+    depth = 0;
+
+    future_positions_size = 0;
+
+    is_lazy = false;
+
+    is_expanded = false;
+
+    evaluation = 100000; // just some random value to signify that there is no evaluation value yet.
+
+    alpha = 100000; // just some random value to signify that there is no alpha value yet.
+
+    beta = 100000; // just some random value to signify that there is no beta value yet.
+
+    // The above two assignments assume this position is the current, starting position.
+
+    number_of_instances ++;
+
+    minimax();
+}
+
+position::position(const vector <vector<char>>& boardP, bool turnP, int depthP, int alphaP, int betaP, bool lazyP)
+{
+    memory_scope scope(memory_boards); // outside of minimax(), which keeps its own accounts, board is all that's allocated.
+
+    board = boardP;
+    is_comp_turn = turnP;
+    depth = depthP;
+    future_positions_size = 0;
+    is_lazy = lazyP;
+    is_expanded = false;
+    evaluation = 100000; // just some random value to signify there is no evaluation value yet.
+    alpha = alphaP;
+    beta = betaP;
+
+    number_of_instances++;
+
+    minimax();
+}
+
+position::position(const vector <vector<char>>& boardP, bool turnP, int depthP, int evaluationP, known_evaluation)
+{
+    memory_scope scope(memory_boards);
+
+    board = boardP;
+    is_comp_turn = turnP;
+    depth = depthP;
+    future_positions_size = 0;
+    is_lazy = true;
+    is_expanded = false;
+    evaluation = evaluationP;
+    alpha = 100000;
+    beta = 100000;
+
+    number_of_instances++;
+}
+
+// GETTERS:
+
+const vector <vector<char>>& position::get_board() const
+{
+    return board;
+}
+
+int position::get_evaluation() const
+{
+    return evaluation;
+}
+
+bool position::get_is_comp_turn() const
+{
+    return is_comp_turn;
+}
+
+int position::get_depth() const
+{
+    return depth;
+}
+
+unique_ptr<position> position::get_a_future_position(int i)
+{
+    expand_future_positions(); // does nothing unless this position is lazy and hasn't been expanded yet.
+
+    return move(future_positions[i]);
+}
+
+vector <unique_ptr<position>> position::get_future_positions()
+{
+    expand_future_positions(); // does nothing unless this position is lazy and hasn't been expanded yet.
+
+    return move(future_positions);
+}
+
+int position::get_future_positions_size() const
+{
+    return future_positions_size;
+}
+
+bool position::get_is_lazy() const
+{
+    return is_lazy;
+}
+
+// SETTERS:
+
+void position::set_board(const vector <vector<char>>& boardP)
+{
+    board = boardP;
+}
+
+void position::set_evaluation (int evalP)
+{
+    evaluation = evalP;
+}
+
+void position::set_is_comp_turn (bool turnP)
+{
+    is_comp_turn = turnP;
+}
+
+void position::set_depth(int depthP)
+{
+    depth = depthP;
+}
+
+void position::set_future_positions_size(int i)
+{
+    future_positions_size = i;
+}
+
+// HELPERS:
+
+bool position::did_computer_win() const
+{
+    return (!is_comp_turn && depth >= 5 && three_in_a_row('C'));
+}
+
+bool position::did_opponent_win() const
+{
+    return (is_comp_turn && depth >= 5 && three_in_a_row('U'));
+}
+
+// Pre-condition: It has already been checked that no one has won the game.
+// Post-condition: The function will return true if the board is full... it is not guaranteed no one has three-in-a-row.
+bool position::is_game_drawn() const
+{
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (board[row][col] == ' ')
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool position::evaluation_in_future_positions(int eval) const
+{
+    for (int i = 0; i < future_positions.size(); i++)
+    {
+        if (future_positions[i]->evaluation == eval)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool position::is_valid_move(const string& coordinates) const
+{
+    coordinate square;
+
+    return is_valid_move(coordinates, square);
+}
+
+bool position::is_valid_move(const string& coordinates, coordinate& square) const
+{
+    // First, check that the coordinates are on the board at all (e.g. "a1" to "c3"):
+
+    if (!parse_coordinates(coordinates, square))
+    {
+        return false;
+    }
+
+    // Now see if the coordinates are empty on the board:
+
+    if (board[square.row][square.col] != ' ') // coordinate is NOT empty... bad!
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void position::expand_future_positions()
+{
+    if (!is_lazy || is_expanded) // eager positions already have their future_positions, and lazy ones only expand once.
+    {
+        return;
+    }
+
+    is_expanded = true;
+
+    TRACE_SCOPE("expand_future_positions");
+
+    if (did_computer_win() || did_opponent_win() || depth == 9) // game is over, so there are no future positions.
+    {
+        return;
+    }
+
+    for (const coordinate& temp: coordinates)
+    {
+        if (board[temp.row][temp.col] == ' ')
+        {
+            memory_scope board_scope(memory_boards);
+
+            vector <vector<char>> copy_board = board;
+
+            if (is_comp_turn)
+            {
+                copy_board[temp.row][temp.col] = 'C';
+            }
+
+            else
+            {
+                copy_board[temp.row][temp.col] = 'U';
+            }
+
+            // No alpha or beta is sent, so that every future position gets its exact evaluation (a pruned branch
+            // would only have a bound). Each one is lazy too, so it costs nothing more until someone opens it.
+
+            unique_ptr<position> pt;
+
+            {
+                memory_scope node_scope(memory_nodes);
+
+                pt = make_unique<position>(copy_board, !is_comp_turn, depth + 1, 100000, 100000, true);
+            }
+
+            memory_scope vector_scope(memory_child_vectors);
+
+            future_positions.push_back(move(pt));
+
+            future_positions_size ++;
+        }
+    }
+}
+
+// PUBLIC STATIC METHODS:
+
+vector<coordinate> position::create_vector_of_coordinate_objects()
+{
+    vector<coordinate> vec;
+
+    // Center first, then the corners, then the edges. The center and corners are on the most lines, so they're
+    // usually the best moves, and alpha-beta cuts off the most when the best moves are searched first:
+
+    const int order[9] = {4, 0, 2, 6, 8, 1, 3, 5, 7}; // square numbers (row * 3 + col).
+
+    for (int square: order)
+    {
+        coordinate temp;
+        temp.row = square / 3;
+        temp.col = square % 3;
+        vec.push_back(temp);
+    }
+
+    return vec;
+}
+
+bool position::parse_coordinates(const string& coordinates, coordinate& square)
+{
+    // First, check if coordinates is only 2 in size:
+
+    if (coordinates.size() != 2)
+    {
+        return false;
+    }
+
+    char first = coordinates[0];
+    char second = coordinates[1];
+
+    // Now check if the first char is a letter between 'A' and 'C', and the second char is a digit between '1' and '3':
+
+    if (!is_acceptable_letter(first) || !is_acceptable_digit(second))
+    {
+        return false;
+    }
+
+    // Now convert char first and char second into board coordinates:
+
+    square.row = (second - '0') - 1;
+
+    if (first == 'A' || first == 'a')
+    {
+        square.col = 0;
+    }
+
+    else if (first == 'B' || first == 'b')
+    {
+        square.col = 1;
+    }
+
+    else
+    {
+        square.col = 2;
+    }
+
+    return true;
+}
+
+bool position::three_in_a_row(const vector <vector<char>>& board, char c)
+{
+    TRACE_SCOPE("three_in_a_row");
+
+    // Diagonals:
+    if (board[0][0] == c && board[1][1] == c && board[2][2] == c)
+    {
+        return true;
+    }
+    if (board [2][0] == c && board[1][1] == c && board[0][2] == c)
+    {
+        return true;
+    }
+
+    // Verticals & Horizontals:
+    for (int i = 0; i < 3; i++)
+    {
+        // Vertical:
+        if (board[0][i] == c && board[1][i] == c && board[2][i] == c)
+        {
+            return true;
+        }
+
+        // Horizontal:
+        if (board[i][0] == c && board[i][1] == c && board[i][2] == c)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unique_ptr<position> position::with_evaluation(const vector <vector<char>>& boardP, bool turnP, int depthP,
+                                               int evaluationP)
+{
+    // Not make_unique, since it can't reach the private constructor:
+
+    return unique_ptr<position>(new position(boardP, turnP, depthP, evaluationP, known_evaluation()));
+}
+
+// PRIVATE METHODS:
+
+void position::minimax()
+{
+    TRACE_SCOPE("minimax");
+
+    // Here's where all the magic happens.
+
+    if (stop_signal != nullptr && *stop_signal) // whoever started this search no longer wants the result.
+    {
+        return;
+    }
+
+    // First, see if this position is won for one side or drawn...
+
+    if (did_computer_win())
+    {
+        evaluation = 1;
+        return;
+    }
+
+    if (did_opponent_win())
+    {
+        evaluation = -1;
+        return;
+    }
+
+    if (depth == 9) // if depth = 9, and no one already won from the above if statements, then the game must be drawn.
+    {
+        evaluation = 0;
+        return;
+    }
+
+    // The game is not over, so look at all positions one move ahead.
+    // Then, set evaluation accordingly, using the minimax algorithm...
+
+    for (const coordinate& temp: coordinates) // running through the coordinates vector.
+    {
+        if (board[temp.row][temp.col] == ' ') // empty spot... put a piece here:
+        {
+            // Now to make a copy of the current board:
+
+            memory_scope board_scope(memory_boards); // for memory accounting, copy_board is charged to boards.
+
+            vector <vector<char>> copy_board = board;
+
+            if (is_comp_turn)
+            {
+                copy_board[temp.row][temp.col] = 'C';
+            }
+
+            else // opponent's turn:
+            {
+                copy_board[temp.row][temp.col] = 'U';
+            }
+
+            // Now to make a new position object, with this updated board that's one move ahead.
+
+            unique_ptr<position> pt;
+
+            {
+                memory_scope node_scope(memory_nodes); // the position object itself is charged to nodes. Everything it
+                                                       // allocates inside is charged to its own category.
+
+                TRACE_SCOPE("construct_child");
+
+                pt = make_unique<position>(copy_board, !is_comp_turn, depth + 1, alpha, beta, is_lazy);
+            }
+
+            if (stop_signal != nullptr && *stop_signal) // pt's evaluation can't be trusted, so stop here too.
+            {
+                return;
+            }
+
+            int future_evaluation = pt->evaluation;
+
+            if (!is_lazy) // a lazy position throws pt away here, and only rebuilds it if expand_future_positions() is called.
+            {
+                memory_scope vector_scope(memory_child_vectors);
+
+                future_positions.push_back(move(pt));
+
+                future_positions_size ++;
+            }
+
+            // Test if a winning move was found for the comp or user:
+
+            if (future_evaluation == 1 && is_comp_turn) // so the comp can make a move that wins...
+            {
+                evaluation = 1;
+                return;
+            }
+
+            if (future_evaluation == -1 && !is_comp_turn) // so the user can make a move that wins for them...
+            {
+                evaluation = -1;
+                return;
+            }
+
+            if (evaluation == 100000) // no evaluation for this position yet, so for now:
+            {
+                evaluation = future_evaluation;
+            }
+
+            else // this position already has an evaluation from a future position previously examined, so I need to see if
+            {    // I should replace it with an updated evaluation value from the current future position being examined now.
+                if (future_evaluation > evaluation && is_comp_turn)
+                {
+                    evaluation = future_evaluation;
+                }
+
+                else if (future_evaluation < evaluation && !is_comp_turn)
+                {
+                    evaluation = future_evaluation;
+                }
+            }
+
+            // ALPHA-BETA PRUNING:
+
+            // Let's check if this position is a MAX block (comp's turn) or MIN block (user's turn):
+
+            if (is_comp_turn) // This is a MAX block... check beta to try to prune, and possibly reset alpha.
+            {
+                // SEE IF I CAN PRUNE:
+                if (beta != 100000 && beta <= evaluation) // there is a real beta value, and it is <= evaluation.
+                {
+                    // This position's evaluation can only stay the same or get higher, since the comp will find the position
+                    // with the highest evaluation (this is a MAX node).
+
+                    // Already, beta is <= evaluation.
+
+                    // Therefore, the user (in the previous MIN node) would not have picked this branch. They
+                    // would have picked the branch with the value of beta (i.e., lowest value).
+
+                    // So, this branch will be TRIMMED.
+
+                    evaluation = 1; // To ensure this branch is not favoured over the previous good branch
+                                    // with the value of beta. The parent MIN node of this current MAX node will
+                                    // definitely NOT like an evaluation of 1 (it's the highest possible evaluation).
+
+                    return;
+                }
+
+                // SEE IF ALPHA SHOULD BE RESET (or given a value, if it doesn't have one yet):
+                if (alpha == 100000 || evaluation > alpha)
+                {
+                    alpha = evaluation;
+                }
+            }
+
+            else // user's turn, so MIN block... check alpha to see if branch should be pruned, and possibly reset beta.
+            {
+                // SEE IF I CAN PRUNE:
+                if (alpha != 100000 && alpha >= evaluation) // there is a real alpha value, and it is >= evaluation.
+                {
+                    // This position's evaluation can only stay the same or get lower, since the user will find the position
+                    // with the lowest evaluation (this is a MIN block).
+
+                    // Already, alpha is >= evaluation.
+
+                    // Therefore, the comp (in the previous MAX node) would not have picked this branch. It would have picked
+                    // the branch with the value of alpha (i.e., highest value).
+
+                    // So, this branch will be TRIMMED.
+
+                    evaluation = -1; // To ensure this branch is not favoured over the previous good branch
+                                     // with the value of alpha. The parent MAX node of this current MIN node will
+                                     // definitely NOT like an evaluation of -1 (it's the lowest possible evaluation).
+
+                    return;
+                }
+
+                // SEE IF BETA SHOULD BE RESET (or given a value, if it doesn't have one yet):
+                if (beta == 100000 || evaluation < beta)
+                {
+                    beta = evaluation;
+                }
+            }
+        }
+    }
+}
+
+bool position::three_in_a_row(char c) const
+{
+    return three_in_a_row(board, c);
+}
+
+// PRIVATE STATIC METHODS:
+
+bool position::is_acceptable_letter(char c)
+{
+    return ((c >= 'A' && c <= 'C') || (c >= 'a' && c <= 'c'));
+}
+
+bool position::is_acceptable_digit(char c)
+{
+    return (c >= '1' && c <= '3');
+}
+
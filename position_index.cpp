@@ -0,0 +1,8 @@
+#include "position_index.h"
+
+// Initializing the static variables (in this order, since each one uses the ones before it):
+
+vector <vector<int>> position_index::binomials = create_binomials();
+vector <vector<int>> position_index::first_ranks = create_first_ranks();
+vector<short> position_index::symmetric_ranks = create_symmetric_ranks();
+vector<int> position_index::canonical_ranks = create_canonical_ranks();
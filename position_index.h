@@ -0,0 +1,360 @@
+/* "position_index" numbers 3x3 boards densely, so a table about boards can be a flat array instead of a hash map.
+
+    - A "rankable" board is one where the two sides' piece counts differ by at most 1 (every board that can come up in
+      a game is one, whoever goes first). There are number_of_positions of them, and get_rank() gives each one a
+      different number from 0 to number_of_positions - 1. get_code() turns a rank back into its board.
+    - Ranks go in order of piece counts (all boards with 0 pieces, then 1, and so on), and within the same counts,
+      by where the computer's pieces are, then where the user's pieces are (each as a combination, i.e. a subset of
+      the squares left, numbered with the combinatorial number system).
+    - get_base3() is the simpler numbering: each square is a digit (0 empty, 1 computer, 2 user), so every board
+      (rankable or not) gets a number below 3^9, with some numbers never used.
+    - get_symmetric_rank() is the same as get_rank(), except boards that are rotations or reflections of each other
+      share a number. The numbers go from 0 to get_number_of_symmetry_classes() - 1.
+    - Boards are passed around as bitboards (see bitboard.h). Whose turn it is isn't part of the board, so a table
+      that needs it can use rank * 2 + is_comp_turn.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "bitboard.h"
+
+using namespace std;
+
+class position_index
+{
+public:
+    static const int number_of_positions = 8953;
+    static const int number_of_base3_codes = 19683; // 3^9.
+
+    // Public static methods:
+    static bool is_rankable(unsigned int code); // returns true if the piece counts differ by at most 1.
+    static int get_rank(unsigned int code); // code has to be rankable.
+    static unsigned int get_code(int rank); // the board with this rank.
+    static int get_base3(unsigned int code);
+    static unsigned int get_code_from_base3(int base3);
+    static int get_symmetric_rank(unsigned int code); // code has to be rankable.
+    static unsigned int get_canonical_code(int symmetric_rank); // the board with the lowest rank among the boards
+                                                                // that share this symmetric rank.
+    static int get_number_of_symmetry_classes();
+    static unsigned int transform(unsigned int code, int symmetry); // symmetry is 0 to 7 (0 leaves code alone): one of
+                                                                    // the 4 rotations, with or without a reflection.
+
+private:
+    // Private static variable(s):
+    static vector <vector<int>> binomials; // binomials[n][k] = n choose k, for n up to 9.
+    static vector <vector<int>> first_ranks; // first_ranks[comp pieces][user pieces]: the rank of the first board
+                                             // with those counts (-1 if the counts aren't rankable).
+    static vector<short> symmetric_ranks; // by rank.
+    static vector<int> canonical_ranks; // by symmetric rank.
+
+    // Private static methods:
+    static int rank_subset(unsigned int mask, unsigned int taken); // returns mask's number among all the subsets (with
+                                                                   // as many squares) of the squares not in taken.
+    static unsigned int unrank_subset(int number, int size, int count);
+    static unsigned int expand(unsigned int mask, unsigned int taken); // spreads mask's bits out over the squares not in
+                                                                       // taken (bit i goes to the i-th of them).
+    static vector <vector<int>> create_binomials();
+    static vector <vector<int>> create_first_ranks();
+    static vector<short> create_symmetric_ranks();
+    static vector<int> create_canonical_ranks();
+};
+
+// The static variables are initialized in position_index.cpp, so that this header can be included by more than one
+// translation unit.
+
+// PUBLIC STATIC METHODS:
+
+inline bool position_index::is_rankable(unsigned int code)
+{
+    int comp_pieces = bitboard::count_pieces(bitboard::get_comp_pieces(code));
+    int user_pieces = bitboard::count_pieces(bitboard::get_user_pieces(code));
+
+    return (bitboard::get_comp_pieces(code) & bitboard::get_user_pieces(code)) == 0 &&
+           comp_pieces - user_pieces <= 1 && user_pieces - comp_pieces <= 1;
+}
+
+inline int position_index::get_rank(unsigned int code)
+{
+    unsigned int comp = bitboard::get_comp_pieces(code);
+    unsigned int user = bitboard::get_user_pieces(code);
+    int comp_pieces = __builtin_popcount(comp);
+    int user_pieces = __builtin_popcount(user);
+
+    // The user's pieces can only be on the 9 - comp_pieces squares the computer left empty:
+
+    int comp_number = rank_subset(comp, 0);
+    int user_number = rank_subset(user, comp);
+
+    return first_ranks[comp_pieces][user_pieces] + comp_number * binomials[9 - comp_pieces][user_pieces] + user_number;
+}
+
+inline unsigned int position_index::get_code(int rank)
+{
+    // Find the piece counts whose boards this rank is among (the one with the biggest first rank not above it):
+
+    int comp_pieces = 0;
+    int user_pieces = 0;
+
+    for (int c = 0; c <= 9; c++)
+    {
+        for (int u = 0; c + u <= 9; u++)
+        {
+            if (first_ranks[c][u] != -1 && first_ranks[c][u] <= rank &&
+                first_ranks[c][u] >= first_ranks[comp_pieces][user_pieces])
+            {
+                comp_pieces = c;
+                user_pieces = u;
+            }
+        }
+    }
+
+    int number = rank - first_ranks[comp_pieces][user_pieces];
+    int user_choices = binomials[9 - comp_pieces][user_pieces];
+
+    unsigned int comp = unrank_subset(number / user_choices, 9, comp_pieces);
+    unsigned int user = expand(unrank_subset(number % user_choices, 9 - comp_pieces, user_pieces), comp);
+
+    return comp | (user << 9);
+}
+
+inline int position_index::get_base3(unsigned int code)
+{
+    int base3 = 0;
+
+    for (int square = 8; square >= 0; square--)
+    {
+        base3 *= 3;
+
+        if (code & (1u << square))
+        {
+            base3 += 1;
+        }
+
+        else if (code & (1u << (9 + square)))
+        {
+            base3 += 2;
+        }
+    }
+
+    return base3;
+}
+
+inline unsigned int position_index::get_code_from_base3(int base3)
+{
+    unsigned int code = 0;
+
+    for (int square = 0; square < 9; square++, base3 /= 3)
+    {
+        if (base3 % 3 == 1)
+        {
+            code |= 1u << square;
+        }
+
+        else if (base3 % 3 == 2)
+        {
+            code |= 1u << (9 + square);
+        }
+    }
+
+    return code;
+}
+
+inline int position_index::get_symmetric_rank(unsigned int code)
+{
+    return symmetric_ranks[get_rank(code)];
+}
+
+inline unsigned int position_index::get_canonical_code(int symmetric_rank)
+{
+    return get_code(canonical_ranks[symmetric_rank]);
+}
+
+inline int position_index::get_number_of_symmetry_classes()
+{
+    return canonical_ranks.size();
+}
+
+inline unsigned int position_index::transform(unsigned int code, int symmetry)
+{
+    unsigned int result = 0;
+
+    for (int square = 0; square < 9; square++)
+    {
+        int row = square / 3;
+        int col = square % 3;
+
+        if (symmetry & 4) // reflect first...
+        {
+            col = 2 - col;
+        }
+
+        for (int turns = 0; turns < (symmetry & 3); turns++) // ...then rotate a quarter turn at a time.
+        {
+            int temp = row;
+            row = col;
+            col = 2 - temp;
+        }
+
+        int to = row * 3 + col;
+
+        if (code & (1u << square))
+        {
+            result |= 1u << to;
+        }
+
+        else if (code & (1u << (9 + square)))
+        {
+            result |= 1u << (9 + to);
+        }
+    }
+
+    return result;
+}
+
+// PRIVATE STATIC METHODS:
+
+inline int position_index::rank_subset(unsigned int mask, unsigned int taken)
+{
+    // The combinatorial number system: the i-th square of mask (counting from 1) adds s choose i, where s is how many
+    // squares not in taken come before it.
+
+    int number = 0;
+    int i = 1;
+
+    for (; mask != 0; mask &= mask - 1)
+    {
+        int square = __builtin_ctz(mask);
+
+        number += binomials[square - __builtin_popcount(taken & ((1u << square) - 1))][i];
+        i ++;
+    }
+
+    return number;
+}
+
+inline unsigned int position_index::unrank_subset(int number, int size, int count)
+{
+    // Going down from the biggest square, take a square whenever skipping it would leave too few numbers:
+
+    unsigned int mask = 0;
+
+    for (int square = size - 1; square >= 0 && count > 0; square--)
+    {
+        if (binomials[square][count] <= number)
+        {
+            number -= binomials[square][count];
+            mask |= 1u << square;
+            count --;
+        }
+    }
+
+    return mask;
+}
+
+inline unsigned int position_index::expand(unsigned int mask, unsigned int taken)
+{
+    unsigned int result = 0;
+    int from = 0;
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (taken & (1u << square))
+        {
+            continue;
+        }
+
+        if (mask & (1u << from))
+        {
+            result |= 1u << square;
+        }
+
+        from ++;
+    }
+
+    return result;
+}
+
+inline vector <vector<int>> position_index::create_binomials()
+{
+    vector <vector<int>> table(10, vector<int>(10, 0)); // n choose k is 0 when k > n, which rank_subset() relies on.
+
+    for (int n = 0; n <= 9; n++)
+    {
+        table[n][0] = 1;
+
+        for (int k = 1; k <= n; k++)
+        {
+            table[n][k] = table[n - 1][k - 1] + table[n - 1][k];
+        }
+    }
+
+    return table;
+}
+
+inline vector <vector<int>> position_index::create_first_ranks()
+{
+    vector <vector<int>> table(10, vector<int>(10, -1));
+    int rank = 0;
+
+    for (int pieces = 0; pieces <= 9; pieces++)
+    {
+        for (int comp_pieces = pieces / 2 - 1; comp_pieces <= pieces / 2 + 1; comp_pieces++)
+        {
+            int user_pieces = pieces - comp_pieces;
+
+            if (comp_pieces < 0 || user_pieces < 0 || comp_pieces - user_pieces > 1 || user_pieces - comp_pieces > 1)
+            {
+                continue;
+            }
+
+            table[comp_pieces][user_pieces] = rank;
+            rank += binomials[9][comp_pieces] * binomials[9 - comp_pieces][user_pieces];
+        }
+    }
+
+    return table;
+}
+
+inline vector<short> position_index::create_symmetric_ranks()
+{
+    vector<short> ranks(number_of_positions);
+    int classes = 0;
+
+    for (int rank = 0; rank < number_of_positions; rank++)
+    {
+        // A board's canonical board is the transformed board with the lowest rank. It's never above rank, so it
+        // already has its symmetric rank by now (unless it's this board itself, which starts a new class):
+
+        unsigned int code = get_code(rank);
+        int canonical = rank;
+
+        for (int symmetry = 1; symmetry < 8; symmetry++)
+        {
+            canonical = min(canonical, get_rank(transform(code, symmetry)));
+        }
+
+        ranks[rank] = (canonical == rank) ? classes++ : ranks[canonical];
+    }
+
+    return ranks;
+}
+
+inline vector<int> position_index::create_canonical_ranks()
+{
+    // Classes are numbered in the order their canonical boards come up, so each new number is a canonical board:
+
+    vector<int> canonicals;
+
+    for (int rank = 0; rank < number_of_positions; rank++)
+    {
+        if (symmetric_ranks[rank] == static_cast<int>(canonicals.size()))
+        {
+            canonicals.push_back(rank);
+        }
+    }
+
+    return canonicals;
+}
@@ -0,0 +1,7 @@
+#include "qubic.h"
+
+// Initializing the static variables:
+
+vector<uint64_t> qubic_engine::line_table = create_line_table();
+
+vector <vector<int>> qubic_engine::lines_through_square = create_lines_through_square();
@@ -0,0 +1,627 @@
+/* "qubic" plays 3D tic-tac-toe on a 4x4x4 cube, where the goal is 4 in a row (in any direction, including through
+   the cube's layers and across its diagonals).
+
+   Encoding:
+    - Square (x, y, z) is bit x + 4 * y + 16 * z, so each side's pieces fit exactly in one uint64_t.
+    - There are 76 winning lines, each kept as a 64-bit mask in line_table. lines_through_square lists the lines each
+      square is on (7 for corners and the 8 center squares, 4 for the rest), so checking if a move won only looks at those.
+
+   Search:
+    - Threats first: if the side to move can finish a line, it does. If the other side has a line with 3 pieces and an
+      empty square, that square is the only move worth looking at (and two such squares means the game is lost).
+      These forced moves don't use up search depth.
+    - Before the main search, find_forced_win() looks for a win made of nothing but threats, since those are quick
+      to check and the main search might not reach deep enough to see them.
+    - Then iterative deepening alpha-beta (negamax), with a transposition table (depth-preferred), until the
+      search_budget runs out. The best move of the last depth that finished is returned.
+ */
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include "search_budget.h"
+#include "memory_stats.h"
+
+using namespace std;
+
+struct qubic_state
+{
+    uint64_t comp; // the computer's pieces.
+    uint64_t user; // the user's pieces.
+    bool comp_to_move;
+};
+
+struct qubic_search_result
+{
+    int best_move = -1; // a square (0-63), or -1 if the game is over.
+    int score = 0; // from the point of view of the side to move.
+    int depth = 0; // the deepest search that finished (0 if a forced win was found before the main search).
+    long long nodes = 0;
+};
+
+class qubic_engine
+{
+public:
+    static const int win_score = 1000000; // a won game scores this minus the number of moves it takes.
+
+    // Public static methods:
+    static qubic_state create_start_state(bool comp_firstP);
+    static qubic_state apply_move(const qubic_state& state, int square);
+    static bool is_win_at(uint64_t pieces, int square); // returns true if pieces has a full line through square.
+    static int find_winning_square(uint64_t own, uint64_t other); // returns a square that completes one of own's lines
+                                                                  // (-1 if there isn't one).
+    static uint64_t get_threat_squares(uint64_t own, uint64_t other); // every square that would complete one of own's lines.
+    static int evaluate(const qubic_state& state); // heuristic score from the side to move's point of view.
+    static int find_forced_win(const qubic_state& state, int max_threats); // returns the first move of a win made only of
+                                                                           // threats (-1 if none is found).
+    static qubic_search_result search(const qubic_state& state, const search_budget& budget); // the budget has to
+                                                                                               // have a deadline or
+                                                                                               // max_nodes.
+    static int count_bits(uint64_t bits);
+
+    static vector<uint64_t> create_line_table(); // creates line_table below.
+    static vector <vector<int>> create_lines_through_square(); // creates lines_through_square below.
+
+    // Public static variable(s):
+    static vector<uint64_t> line_table; // the 76 winning lines.
+    static vector <vector<int>> lines_through_square; // for each square, the indexes in line_table of its lines.
+
+private:
+    struct table_entry
+    {
+        uint64_t key = 0;
+        int score = 0;
+        signed char depth = -1; // -1 for an empty entry.
+        signed char bound = 0; // 0 exact, 1 lower bound, 2 upper bound.
+        signed char best_move = -1;
+    };
+
+    friend void test_qubic(); // checks store_in_table() on a small table of its own.
+
+    // Private static methods:
+    static uint64_t hash(const qubic_state& state);
+    static void store_in_table(vector<table_entry>& table, uint64_t key, int score, int depth, int bound,
+                               int best_move); // depth-preferred: a shallower result never replaces a deeper one,
+                                               // even for a different position.
+    static int negamax(const qubic_state& state, int depth, int alpha, int beta, int ply, vector<table_entry>& table,
+                       long long& nodes, const search_budget& budget, bool& out_of_budget);
+    static int order_moves(const qubic_state& state, uint64_t candidates, int table_move, int moves[64]); // fills moves,
+                                                                                                          // and returns
+                                                                                                          // how many.
+    static bool attacker_wins(const qubic_state& state, int max_threats); // state has the attacker to move.
+};
+
+// The static variables are initialized in qubic.cpp, so that this header can be included by more than one
+// translation unit.
+
+// PUBLIC STATIC METHODS:
+
+inline qubic_state qubic_engine::create_start_state(bool comp_firstP)
+{
+    qubic_state state;
+
+    state.comp = 0;
+    state.user = 0;
+    state.comp_to_move = comp_firstP;
+
+    return state;
+}
+
+inline qubic_state qubic_engine::apply_move(const qubic_state& state, int square)
+{
+    qubic_state next = state;
+
+    if (state.comp_to_move)
+    {
+        next.comp |= uint64_t(1) << square;
+    }
+
+    else
+    {
+        next.user |= uint64_t(1) << square;
+    }
+
+    next.comp_to_move = !state.comp_to_move;
+
+    return next;
+}
+
+inline bool qubic_engine::is_win_at(uint64_t pieces, int square)
+{
+    for (int line: lines_through_square[square])
+    {
+        if ((pieces & line_table[line]) == line_table[line])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline int qubic_engine::find_winning_square(uint64_t own, uint64_t other)
+{
+    uint64_t threats = get_threat_squares(own, other);
+
+    if (threats == 0)
+    {
+        return -1;
+    }
+
+    return count_bits((threats & (~threats + 1)) - 1); // index of the lowest set bit.
+}
+
+inline uint64_t qubic_engine::get_threat_squares(uint64_t own, uint64_t other)
+{
+    uint64_t threats = 0;
+
+    for (uint64_t line: line_table)
+    {
+        if ((other & line) == 0 && count_bits(own & line) == 3)
+        {
+            threats |= line & ~own;
+        }
+    }
+
+    return threats;
+}
+
+inline int qubic_engine::evaluate(const qubic_state& state)
+{
+    const int weights[4] = {0, 1, 6, 40}; // how much a line with 0-3 of one side's pieces (and none of the other's) is worth.
+
+    int score = 0;
+
+    for (uint64_t line: line_table)
+    {
+        int comp_count = count_bits(state.comp & line);
+        int user_count = count_bits(state.user & line);
+
+        if (user_count == 0)
+        {
+            score += weights[comp_count];
+        }
+
+        if (comp_count == 0)
+        {
+            score -= weights[user_count];
+        }
+    }
+
+    return state.comp_to_move ? score : -score;
+}
+
+inline int qubic_engine::find_forced_win(const qubic_state& state, int max_threats)
+{
+    uint64_t own = state.comp_to_move ? state.comp : state.user;
+    uint64_t other = state.comp_to_move ? state.user : state.comp;
+    uint64_t empty = ~(own | other);
+
+    int win = find_winning_square(own, other);
+
+    if (win != -1)
+    {
+        return win;
+    }
+
+    for (int square = 0; square < 64; square++)
+    {
+        if ((empty >> square) & 1)
+        {
+            qubic_state next = apply_move(state, square);
+            uint64_t next_own = own | (uint64_t(1) << square);
+
+            // Only moves that make a threat are tried, so the other side's reply is always forced:
+
+            if (get_threat_squares(next_own, other) == 0)
+            {
+                continue;
+            }
+
+            // attacker_wins() wants the attacker to move, so play the forced block first:
+
+            uint64_t blocks = get_threat_squares(next_own, other);
+
+            if (count_bits(blocks) >= 2 && find_winning_square(other, next_own) == -1)
+            {
+                return square; // two threats at once, and the other side can't win first.
+            }
+
+            if (count_bits(blocks) == 1 && find_winning_square(other, next_own) == -1)
+            {
+                int block = count_bits((blocks & (~blocks + 1)) - 1);
+
+                if (attacker_wins(apply_move(next, block), max_threats - 1))
+                {
+                    return square;
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+inline qubic_search_result qubic_engine::search(const qubic_state& state, const search_budget& budget)
+{
+    qubic_search_result result;
+
+    uint64_t empty = ~(state.comp | state.user);
+
+    if (empty == 0)
+    {
+        return result;
+    }
+
+    // Threats first:
+
+    int forced = find_forced_win(state, 8);
+
+    if (forced != -1)
+    {
+        result.best_move = forced;
+        result.score = win_score;
+        return result;
+    }
+
+    vector<table_entry> table;
+
+    {
+        memory_scope scope(memory_cache);
+
+        table.resize(1 << 20); // 16 MB.
+    }
+
+    int moves[64];
+    int count = order_moves(state, empty, -1, moves);
+
+    // If the other side is threatening to win, only blocking moves are worth searching:
+
+    uint64_t own = state.comp_to_move ? state.comp : state.user;
+    uint64_t other = state.comp_to_move ? state.user : state.comp;
+    uint64_t blocks = get_threat_squares(other, own);
+
+    if (blocks != 0)
+    {
+        count = order_moves(state, blocks, -1, moves);
+    }
+
+    bool out_of_budget = false;
+
+    for (int depth = 1; depth <= 64; depth++)
+    {
+        int alpha = -win_score - 1;
+        int best = -1;
+
+        for (int i = 0; i < count; i++)
+        {
+            int score = -negamax(apply_move(state, moves[i]), depth - 1, -win_score - 1, -alpha, 1, table, result.nodes,
+                                 budget, out_of_budget);
+
+            if (out_of_budget)
+            {
+                break;
+            }
+
+            if (score > alpha)
+            {
+                alpha = score;
+                best = i;
+            }
+        }
+
+        if (out_of_budget) // this depth didn't finish, so stick with the last one that did.
+        {
+            break;
+        }
+
+        result.best_move = moves[best];
+        result.score = alpha;
+        result.depth = depth;
+
+        // Search this depth's best move first next time:
+
+        int temp = moves[best];
+        moves[best] = moves[0];
+        moves[0] = temp;
+
+        if (alpha >= win_score - 64 || alpha <= -win_score + 64) // the game is decided, so searching deeper won't help.
+        {
+            break;
+        }
+    }
+
+    if (result.best_move == -1) // not even depth 1 finished, so the best looking move will have to do.
+    {
+        result.best_move = moves[0];
+    }
+
+    return result;
+}
+
+inline int qubic_engine::count_bits(uint64_t bits)
+{
+    int count = 0;
+
+    for (; bits != 0; bits &= bits - 1) // each time through, the lowest set bit is removed.
+    {
+        count ++;
+    }
+
+    return count;
+}
+
+inline vector<uint64_t> qubic_engine::create_line_table()
+{
+    vector<uint64_t> lines;
+
+    // Every direction, counting each one only once (not also its opposite), so the first non-zero step is positive:
+
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dz = -1; dz <= 1; dz++)
+            {
+                bool first_non_zero_is_positive = (dx > 0) || (dx == 0 && dy > 0) || (dx == 0 && dy == 0 && dz > 0);
+
+                if (!first_non_zero_is_positive)
+                {
+                    continue;
+                }
+
+                // Every starting square where all 4 squares of the line fit in the cube:
+
+                for (int x = 0; x < 4; x++)
+                {
+                    for (int y = 0; y < 4; y++)
+                    {
+                        for (int z = 0; z < 4; z++)
+                        {
+                            int end_x = x + 3 * dx;
+                            int end_y = y + 3 * dy;
+                            int end_z = z + 3 * dz;
+
+                            if (end_x < 0 || end_x > 3 || end_y < 0 || end_y > 3 || end_z < 0 || end_z > 3)
+                            {
+                                continue;
+                            }
+
+                            uint64_t line = 0;
+
+                            for (int step = 0; step < 4; step++)
+                            {
+                                line |= uint64_t(1) << ((x + step * dx) + 4 * (y + step * dy) + 16 * (z + step * dz));
+                            }
+
+                            lines.push_back(line);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return lines;
+}
+
+inline vector <vector<int>> qubic_engine::create_lines_through_square()
+{
+    vector <vector<int>> result(64);
+
+    for (size_t line = 0; line < line_table.size(); line++)
+    {
+        for (int square = 0; square < 64; square++)
+        {
+            if ((line_table[line] >> square) & 1)
+            {
+                result[square].push_back(line);
+            }
+        }
+    }
+
+    return result;
+}
+
+// PRIVATE STATIC METHODS:
+
+inline void qubic_engine::store_in_table(vector<table_entry>& table, uint64_t key, int score, int depth, int bound,
+                                  int best_move)
+{
+    table_entry& entry = table[key & (table.size() - 1)];
+
+    // An empty entry has depth -1, so anything goes in. Otherwise the deeper result stays, whichever position it's for
+    // (a deep result took much longer to find, and is worth more on the next iteration):
+
+    if (depth >= entry.depth)
+    {
+        entry.key = key;
+        entry.score = score;
+        entry.depth = depth;
+        entry.bound = bound;
+        entry.best_move = best_move;
+    }
+}
+
+inline uint64_t qubic_engine::hash(const qubic_state& state)
+{
+    uint64_t h = state.comp * 0x9E3779B97F4A7C15ULL ^ (state.user + 0x632BE59BD9B4E019ULL) * 0xBF58476D1CE4E5B9ULL;
+
+    if (state.comp_to_move)
+    {
+        h = ~h;
+    }
+
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 29;
+
+    return h;
+}
+
+inline int qubic_engine::negamax(const qubic_state& state, int depth, int alpha, int beta, int ply,
+                          vector<table_entry>& table, long long& nodes, const search_budget& budget,
+                          bool& out_of_budget)
+{
+    nodes ++;
+
+    if ((nodes & 1023) == 0 &&
+        (chrono::steady_clock::now() >= budget.deadline || (budget.max_nodes != 0 && nodes >= budget.max_nodes)))
+    {
+        out_of_budget = true;
+    }
+
+    if (out_of_budget)
+    {
+        return 0;
+    }
+
+    uint64_t own = state.comp_to_move ? state.comp : state.user;
+    uint64_t other = state.comp_to_move ? state.user : state.comp;
+
+    // The last move can't have won, since a side with a winning square always takes it (below) and never gets here.
+
+    uint64_t empty = ~(own | other);
+
+    if (empty == 0)
+    {
+        return 0;
+    }
+
+    // Threats: winning right now beats everything, and the other side's threats have to be blocked.
+
+    if (get_threat_squares(own, other) != 0)
+    {
+        return win_score - ply - 1;
+    }
+
+    uint64_t blocks = get_threat_squares(other, own);
+
+    if (count_bits(blocks) >= 2)
+    {
+        return -(win_score - ply - 2); // only one of them can be blocked.
+    }
+
+    if (depth <= 0 && blocks == 0)
+    {
+        return evaluate(state);
+    }
+
+    uint64_t key = hash(state);
+    table_entry& entry = table[key & (table.size() - 1)];
+    int table_move = -1;
+
+    if (entry.key == key)
+    {
+        table_move = entry.best_move;
+
+        if (entry.depth >= depth &&
+            (entry.bound == 0 || (entry.bound == 1 && entry.score >= beta) || (entry.bound == 2 && entry.score <= alpha)))
+        {
+            return entry.score;
+        }
+    }
+
+    int moves[64];
+    int count = order_moves(state, blocks != 0 ? blocks : empty, table_move, moves);
+    int next_depth = (blocks != 0) ? depth : depth - 1; // a forced block doesn't use up depth.
+
+    int original_alpha = alpha;
+    int best_score = -win_score - 1;
+    int best_move = moves[0];
+
+    for (int i = 0; i < count; i++)
+    {
+        int score = -negamax(apply_move(state, moves[i]), next_depth, -beta, -alpha, ply + 1, table, nodes, budget,
+                             out_of_budget);
+
+        if (out_of_budget)
+        {
+            return 0;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_move = moves[i];
+        }
+
+        if (score > alpha)
+        {
+            alpha = score;
+        }
+
+        if (alpha >= beta)
+        {
+            break;
+        }
+    }
+
+    store_in_table(table, key, best_score, depth, (best_score <= original_alpha) ? 2 : ((best_score >= beta) ? 1 : 0),
+                   best_move);
+
+    return best_score;
+}
+
+inline int qubic_engine::order_moves(const qubic_state& state, uint64_t candidates, int table_move, int moves[64])
+{
+    // Squares on more lines that are still open are usually better, so they go first (after the table's move):
+
+    int count = 0;
+    int values[64];
+
+    for (int square = 0; square < 64; square++)
+    {
+        if (!((candidates >> square) & 1))
+        {
+            continue;
+        }
+
+        int value = 0;
+
+        for (int line: lines_through_square[square])
+        {
+            uint64_t mask = line_table[line];
+
+            if ((state.comp & mask) == 0 || (state.user & mask) == 0) // someone could still finish this line.
+            {
+                value ++;
+            }
+        }
+
+        if (square == table_move)
+        {
+            value = 1000;
+        }
+
+        // Insertion sort, biggest value first:
+
+        int i = count;
+
+        while (i > 0 && values[i - 1] < value)
+        {
+            values[i] = values[i - 1];
+            moves[i] = moves[i - 1];
+            i--;
+        }
+
+        values[i] = value;
+        moves[i] = square;
+        count ++;
+    }
+
+    return count;
+}
+
+inline bool qubic_engine::attacker_wins(const qubic_state& state, int max_threats)
+{
+    if (max_threats <= 0)
+    {
+        return false;
+    }
+
+    return find_forced_win(state, max_threats) != -1;
+}
@@ -0,0 +1,455 @@
+/* The "regression_harness" checks that the engine's faster code paths still play exactly like a slow, obviously
+   correct minimax, and that they haven't gotten slower.
+
+    - Differential check: every position that can come up in a real game (with either side going first) is searched
+      by a reference minimax with no pruning, no bitboards and no tricks. Each faster path is then compared against it:
+        - a normal position: same evaluation, and every move it rates best really is one of the best moves (pruning
+          means it may not find all of them).
+        - a lazy position, once expanded: same evaluation, and exactly the same set of best moves.
+        - engine::search(): same evaluation, and its move is one of the best moves.
+        - tree_store: every node of the full tree has the reference score.
+    - Perf gate: times full searches of the empty board, and fails if nodes/sec or the time per search is worse than a
+      stored baseline by more than a threshold. If there's no baseline yet, the current numbers are saved as the
+      baseline, but the gate reports perf_gate_no_baseline rather than passing (the baseline file isn't checked in,
+      so a fresh checkout would otherwise always pass).
+ */
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "position.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "tree_store.h"
+
+using namespace std;
+
+enum perf_gate_result
+{
+    perf_gate_passed,
+    perf_gate_failed,
+    perf_gate_no_baseline // nothing to compare against (the numbers just measured were saved as the baseline).
+};
+
+struct perf_numbers
+{
+    double nodes_per_second = 0; // position objects created per second.
+    double seconds_per_search = 0; // time for one full search of the empty board.
+};
+
+class regression_harness
+{
+public:
+    // Public static methods:
+    static map<pair<unsigned int, bool>, int> enumerate_reachable_positions(); // maps every reachable (bitboard,
+                                                                                 // is_comp_turn) pair to its
+                                                                                 // reference score.
+    static int reference_minimax(vector <vector<char>>& board, bool is_comp_turn); // plain minimax, no pruning.
+    static vector<coordinate> reference_best_moves(const vector <vector<char>>& board, bool is_comp_turn);
+
+    static int run_differential_check(ostream& out); // returns the number of mismatches found (0 is good).
+
+    static perf_numbers measure_performance(int searches); // does this many full searches of the empty board.
+    static perf_gate_result run_perf_gate(ostream& out, const string& baseline_file,
+                                          double threshold); // passes if the numbers are within threshold (e.g.
+                                                             // 0.25 = 25%) of the baseline.
+
+private:
+    // Private static methods:
+    static bool reference_has_won(const vector <vector<char>>& board, char c); // its own 3-in-a-row check, so it
+                                                                               // doesn't share a bug with position.
+    static void add_reachable(vector <vector<char>>& board, bool is_comp_turn, map<pair<unsigned int, bool>, int>& found);
+    static bool contains(const vector<coordinate>& moves, int row, int col);
+    static coordinate find_move(const vector <vector<char>>& before, const vector <vector<char>>& after); // returns
+                                                                                                         // the square
+                                                                                                         // that differs.
+};
+
+// PUBLIC STATIC METHODS:
+
+inline map<pair<unsigned int, bool>, int> regression_harness::enumerate_reachable_positions()
+{
+    map<pair<unsigned int, bool>, int> found;
+
+    vector <vector<char>> board(3, vector<char>(3, ' '));
+
+    add_reachable(board, true, found); // games where the computer goes first.
+    add_reachable(board, false, found); // games where the user goes first.
+
+    for (auto& entry: found)
+    {
+        vector <vector<char>> entry_board = bitboard::decode(entry.first.first);
+
+        entry.second = reference_minimax(entry_board, entry.first.second);
+    }
+
+    return found;
+}
+
+inline int regression_harness::reference_minimax(vector <vector<char>>& board, bool is_comp_turn)
+{
+    if (!is_comp_turn && reference_has_won(board, 'C'))
+    {
+        return 1;
+    }
+
+    if (is_comp_turn && reference_has_won(board, 'U'))
+    {
+        return -1;
+    }
+
+    int best = 100000;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (board[row][col] != ' ')
+            {
+                continue;
+            }
+
+            board[row][col] = is_comp_turn ? 'C' : 'U';
+
+            int score = reference_minimax(board, !is_comp_turn);
+
+            board[row][col] = ' ';
+
+            if (best == 100000 || (is_comp_turn && score > best) || (!is_comp_turn && score < best))
+            {
+                best = score;
+            }
+        }
+    }
+
+    if (best == 100000) // no empty squares, and no one won.
+    {
+        return 0;
+    }
+
+    return best;
+}
+
+inline vector<coordinate> regression_harness::reference_best_moves(const vector <vector<char>>& board, bool is_comp_turn)
+{
+    vector <vector<char>> copy_board = board;
+    vector<coordinate> best_moves;
+    int best = 100000;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (copy_board[row][col] != ' ')
+            {
+                continue;
+            }
+
+            copy_board[row][col] = is_comp_turn ? 'C' : 'U';
+
+            int score = reference_minimax(copy_board, !is_comp_turn);
+
+            copy_board[row][col] = ' ';
+
+            if (best == 100000 || (is_comp_turn && score > best) || (!is_comp_turn && score < best))
+            {
+                best = score;
+                best_moves.clear();
+            }
+
+            if (score == best)
+            {
+                best_moves.push_back({row, col});
+            }
+        }
+    }
+
+    return best_moves;
+}
+
+inline int regression_harness::run_differential_check(ostream& out)
+{
+    map<pair<unsigned int, bool>, int> reference = enumerate_reachable_positions();
+
+    int mismatches = 0;
+
+    for (const auto& entry: reference)
+    {
+        vector <vector<char>> board = bitboard::decode(entry.first.first);
+        bool is_comp_turn = entry.first.second;
+        int depth = bitboard::count_pieces(entry.first.first);
+        int expected = entry.second;
+
+        bool game_over = reference_has_won(board, is_comp_turn ? 'U' : 'C') || depth == 9;
+
+        vector<coordinate> expected_moves;
+
+        if (!game_over)
+        {
+            expected_moves = reference_best_moves(board, is_comp_turn);
+        }
+
+        // Normal position (with pruning, some best moves may look worse than they are, so it's enough that every
+        // move it rates best really is a best move):
+
+        position eager_p(board, is_comp_turn, depth, 100000, 100000);
+
+        vector <unique_ptr<position>> eager_futures = eager_p.get_future_positions();
+
+        int eager_best_count = 0;
+        bool eager_wrong_move = false;
+
+        for (const unique_ptr<position>& future: eager_futures)
+        {
+            if (future->get_evaluation() == eager_p.get_evaluation())
+            {
+                coordinate move = find_move(board, future->get_board());
+
+                eager_best_count ++;
+
+                if (!contains(expected_moves, move.row, move.col))
+                {
+                    eager_wrong_move = true;
+                }
+            }
+        }
+
+        if (eager_p.get_evaluation() != expected || eager_wrong_move || (!game_over && eager_best_count == 0))
+        {
+            out << "Mismatch (normal position): " << entry.first.first << ", comp turn " << is_comp_turn << "\n";
+            mismatches ++;
+        }
+
+        // Lazy position (no pruning once expanded, so the best moves should match exactly):
+
+        position lazy_p(board, is_comp_turn, depth, 100000, 100000, true);
+
+        vector <unique_ptr<position>> lazy_futures = lazy_p.get_future_positions();
+
+        int lazy_best_count = 0;
+        bool lazy_wrong_move = false;
+
+        for (const unique_ptr<position>& future: lazy_futures)
+        {
+            if (future->get_evaluation() == lazy_p.get_evaluation())
+            {
+                coordinate move = find_move(board, future->get_board());
+
+                lazy_best_count ++;
+
+                if (!contains(expected_moves, move.row, move.col))
+                {
+                    lazy_wrong_move = true;
+                }
+            }
+        }
+
+        if (lazy_p.get_evaluation() != expected || lazy_wrong_move ||
+            lazy_best_count != static_cast<int>(expected_moves.size()))
+        {
+            out << "Mismatch (lazy position): " << entry.first.first << ", comp turn " << is_comp_turn << "\n";
+            mismatches ++;
+        }
+
+        // engine::search() (only when there's a move to find):
+
+        if (!game_over)
+        {
+            search_request request;
+
+            request.board = board;
+            request.is_comp_turn = is_comp_turn;
+            request.depth = depth;
+
+            search_result result = engine::search(request);
+
+            if (!result.completed || result.evaluation != expected ||
+                !contains(expected_moves, result.best_move.row, result.best_move.col))
+            {
+                out << "Mismatch (engine): " << entry.first.first << ", comp turn " << is_comp_turn << "\n";
+                mismatches ++;
+            }
+        }
+    }
+
+    // tree_store, from the empty board with each side going first:
+
+    for (int first = 0; first < 2; first++)
+    {
+        tree_store tree;
+
+        tree.build(vector <vector<char>>(3, vector<char>(3, ' ')), first == 0);
+
+        int tree_mismatches = 0;
+
+        tree.for_each_breadth_first([&](int i)
+        {
+            auto entry = reference.find(make_pair(tree.get_board_code(i), tree.get_is_comp_turn(i)));
+
+            if (entry == reference.end() || entry->second != tree.get_score(i))
+            {
+                tree_mismatches ++;
+            }
+        });
+
+        if (tree_mismatches > 0)
+        {
+            out << "Mismatch (tree_store): " << tree_mismatches << " nodes\n";
+            mismatches += tree_mismatches;
+        }
+    }
+
+    out << "Differential check: " << reference.size() << " positions, " << mismatches << " mismatches.\n";
+
+    return mismatches;
+}
+
+inline perf_numbers regression_harness::measure_performance(int searches)
+{
+    perf_numbers numbers;
+
+    vector <vector<char>> board(3, vector<char>(3, ' '));
+
+    int instances_before = position::number_of_instances;
+
+    chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+
+    for (int i = 0; i < searches; i++)
+    {
+        position p1(board, true, 0, 100000, 100000); // depth 0, so every line is searched to the end of the game.
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+
+    numbers.nodes_per_second = (position::number_of_instances - instances_before) / seconds;
+    numbers.seconds_per_search = seconds / searches;
+
+    return numbers;
+}
+
+inline perf_gate_result regression_harness::run_perf_gate(ostream& out, const string& baseline_file, double threshold)
+{
+    perf_numbers current = measure_performance(50);
+
+    out << "Now: " << current.nodes_per_second << " nodes/sec, " << current.seconds_per_search << " seconds/search.\n";
+
+    ifstream baseline_in(baseline_file);
+
+    perf_numbers baseline;
+
+    if (!(baseline_in >> baseline.nodes_per_second >> baseline.seconds_per_search))
+    {
+        ofstream baseline_out(baseline_file);
+
+        baseline_out << current.nodes_per_second << " " << current.seconds_per_search << "\n";
+
+        out << "No baseline found, so these numbers were saved as the baseline (nothing was compared).\n";
+
+        return perf_gate_no_baseline;
+    }
+
+    out << "Baseline: " << baseline.nodes_per_second << " nodes/sec, " << baseline.seconds_per_search
+        << " seconds/search.\n";
+
+    perf_gate_result result = perf_gate_passed;
+
+    if (current.nodes_per_second < baseline.nodes_per_second * (1 - threshold))
+    {
+        out << "REGRESSION: nodes/sec dropped by more than " << threshold * 100 << "%.\n";
+        result = perf_gate_failed;
+    }
+
+    if (current.seconds_per_search > baseline.seconds_per_search * (1 + threshold))
+    {
+        out << "REGRESSION: seconds/search went up by more than " << threshold * 100 << "%.\n";
+        result = perf_gate_failed;
+    }
+
+    return result;
+}
+
+// PRIVATE STATIC METHODS:
+
+inline bool regression_harness::reference_has_won(const vector <vector<char>>& board, char c)
+{
+    const int lines[8][3][2] =
+    {
+        {{0, 0}, {0, 1}, {0, 2}}, {{1, 0}, {1, 1}, {1, 2}}, {{2, 0}, {2, 1}, {2, 2}}, // rows
+        {{0, 0}, {1, 0}, {2, 0}}, {{0, 1}, {1, 1}, {2, 1}}, {{0, 2}, {1, 2}, {2, 2}}, // columns
+        {{0, 0}, {1, 1}, {2, 2}}, {{2, 0}, {1, 1}, {0, 2}}                            // diagonals
+    };
+
+    for (const auto& line: lines)
+    {
+        if (board[line[0][0]][line[0][1]] == c && board[line[1][0]][line[1][1]] == c && board[line[2][0]][line[2][1]] == c)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void regression_harness::add_reachable(vector <vector<char>>& board, bool is_comp_turn,
+                                       map<pair<unsigned int, bool>, int>& found)
+{
+    if (!found.insert(make_pair(make_pair(bitboard::encode(board), is_comp_turn), 0)).second)
+    {
+        return; // already seen, along with everything reachable from it.
+    }
+
+    if (reference_has_won(board, 'C') || reference_has_won(board, 'U'))
+    {
+        return;
+    }
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (board[row][col] == ' ')
+            {
+                board[row][col] = is_comp_turn ? 'C' : 'U';
+
+                add_reachable(board, !is_comp_turn, found);
+
+                board[row][col] = ' ';
+            }
+        }
+    }
+}
+
+inline bool regression_harness::contains(const vector<coordinate>& moves, int row, int col)
+{
+    for (const coordinate& move: moves)
+    {
+        if (move.row == row && move.col == col)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline coordinate regression_harness::find_move(const vector <vector<char>>& before, const vector <vector<char>>& after)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            if (before[row][col] != after[row][col])
+            {
+                return {row, col};
+            }
+        }
+    }
+
+    return {-1, -1};
+}
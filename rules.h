@@ -0,0 +1,421 @@
+/* Rule variants of 3x3 tic-tac-toe, each as a "rules" struct that a variant_solver<Rules> is compiled with. Since the
+   rules are a template parameter, every variant gets its own copy of the search, with its move generation and game
+   over checks inlined, instead of one search that keeps asking which variant it's playing.
+
+    - standard_rules: normal tic-tac-toe (the same game position plays), using bitboard's 3-in-a-row table.
+    - misere_rules: the same, except whoever makes 3-in-a-row loses.
+    - wild_rules: on each turn, the player to move can put either an X or an O on the board. Whoever makes 3-in-a-row
+      (of either kind) wins.
+    - numerical_rules: the players put down the numbers 1-9, each number at most once. The player who moves first
+      uses the odd numbers, and the other player uses the even ones. Whoever fills a line (of 3 squares) whose numbers
+      add up to 15 wins.
+
+   Every rules struct has:
+    - a "state" type, and start_state(bool comp_firstP).
+    - generate_moves(state, moves): fills moves (an array of max_moves ints), and returns how many there are.
+    - apply_move(state, move): returns the state after the player to move plays move.
+    - get_value(state, game_over): for the state right after a move, sets game_over, and if the game is over returns
+      1, 0 or -1 (the player to move has won, drawn or lost).
+    - get_key(state): a unique 64-bit number for the state, so solved states can be remembered.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "bitboard.h"
+#include "memory_stats.h"
+#include "tracing.h"
+
+using namespace std;
+
+struct standard_rules
+{
+    struct state
+    {
+        unsigned int code; // a bitboard: the computer's pieces in the low 9 bits, the user's in the next 9.
+        bool comp_to_move;
+    };
+
+    static const int max_moves = 9;
+
+    static state start_state(bool comp_firstP)
+    {
+        state s;
+
+        s.code = 0;
+        s.comp_to_move = comp_firstP;
+
+        return s;
+    }
+
+    static int generate_moves(const state& s, int moves[])
+    {
+        int count = 0;
+
+        for (unsigned int empty = bitboard::get_empty_squares(s.code); empty != 0; empty &= empty - 1)
+        {
+            moves[count++] = bitboard::count_pieces((empty & (~empty + 1)) - 1); // index of the lowest set bit.
+        }
+
+        return count;
+    }
+
+    static state apply_move(const state& s, int move)
+    {
+        state next = s;
+
+        next.code |= 1u << (s.comp_to_move ? move : 9 + move);
+        next.comp_to_move = !s.comp_to_move;
+
+        return next;
+    }
+
+    static int get_value(const state& s, bool& game_over)
+    {
+        // Only the player who just moved can have a new 3-in-a-row:
+
+        unsigned int mover_pieces = s.comp_to_move ? bitboard::get_user_pieces(s.code) : bitboard::get_comp_pieces(s.code);
+
+        game_over = true;
+
+        if (bitboard::is_three_in_a_row(mover_pieces))
+        {
+            return -1;
+        }
+
+        if (bitboard::get_empty_squares(s.code) == 0)
+        {
+            return 0;
+        }
+
+        game_over = false;
+
+        return 0;
+    }
+
+    static uint64_t get_key(const state& s)
+    {
+        return s.code | (uint64_t(s.comp_to_move) << 18);
+    }
+};
+
+struct misere_rules: standard_rules
+{
+    static int get_value(const state& s, bool& game_over)
+    {
+        unsigned int mover_pieces = s.comp_to_move ? bitboard::get_user_pieces(s.code) : bitboard::get_comp_pieces(s.code);
+
+        game_over = true;
+
+        if (bitboard::is_three_in_a_row(mover_pieces))
+        {
+            return 1; // the player who just moved made 3-in-a-row, so the player to move has won.
+        }
+
+        if (bitboard::get_empty_squares(s.code) == 0)
+        {
+            return 0;
+        }
+
+        game_over = false;
+
+        return 0;
+    }
+};
+
+struct wild_rules
+{
+    struct state
+    {
+        unsigned int code; // the X's in the low 9 bits, the O's in the next 9 (X's and O's don't belong to anyone).
+        bool comp_to_move;
+    };
+
+    static const int max_moves = 18; // each empty square, with an X or an O.
+
+    static state start_state(bool comp_firstP)
+    {
+        state s;
+
+        s.code = 0;
+        s.comp_to_move = comp_firstP;
+
+        return s;
+    }
+
+    static int generate_moves(const state& s, int moves[]) // a move is square * 2, plus 1 for an O.
+    {
+        int count = 0;
+
+        for (unsigned int empty = bitboard::get_empty_squares(s.code); empty != 0; empty &= empty - 1)
+        {
+            int square = bitboard::count_pieces((empty & (~empty + 1)) - 1);
+
+            moves[count++] = square * 2;
+            moves[count++] = square * 2 + 1;
+        }
+
+        return count;
+    }
+
+    static state apply_move(const state& s, int move)
+    {
+        state next = s;
+
+        next.code |= 1u << ((move & 1) ? 9 + move / 2 : move / 2);
+        next.comp_to_move = !s.comp_to_move;
+
+        return next;
+    }
+
+    static int get_value(const state& s, bool& game_over)
+    {
+        game_over = true;
+
+        if (bitboard::is_three_in_a_row(bitboard::get_comp_pieces(s.code)) ||
+            bitboard::is_three_in_a_row(bitboard::get_user_pieces(s.code)))
+        {
+            return -1; // whoever just moved made it, so the player to move has lost.
+        }
+
+        if (bitboard::get_empty_squares(s.code) == 0)
+        {
+            return 0;
+        }
+
+        game_over = false;
+
+        return 0;
+    }
+
+    static uint64_t get_key(const state& s)
+    {
+        return s.code | (uint64_t(s.comp_to_move) << 18);
+    }
+};
+
+struct numerical_rules
+{
+    struct state
+    {
+        uint64_t squares; // 4 bits per square, holding its number (0 if it's empty).
+        unsigned int used; // bit n is set if the number n has been put down.
+        int number_of_pieces;
+        bool comp_to_move;
+    };
+
+    static const int max_moves = 45; // 9 squares, with one of 5 numbers.
+
+    static state start_state(bool comp_firstP)
+    {
+        state s;
+
+        s.squares = 0;
+        s.used = 0;
+        s.number_of_pieces = 0;
+        s.comp_to_move = comp_firstP;
+
+        return s;
+    }
+
+    static int generate_moves(const state& s, int moves[]) // a move is square * 10 + number.
+    {
+        int count = 0;
+        int first_number = (s.number_of_pieces % 2 == 0) ? 1 : 2; // the first player has the odd numbers.
+
+        for (int square = 0; square < 9; square++)
+        {
+            if (get_number(s, square) != 0)
+            {
+                continue;
+            }
+
+            for (int number = first_number; number <= 9; number += 2)
+            {
+                if (!(s.used & (1u << number)))
+                {
+                    moves[count++] = square * 10 + number;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    static state apply_move(const state& s, int move)
+    {
+        state next = s;
+
+        next.squares |= uint64_t(move % 10) << (4 * (move / 10));
+        next.used |= 1u << (move % 10);
+        next.number_of_pieces ++;
+        next.comp_to_move = !s.comp_to_move;
+
+        return next;
+    }
+
+    static int get_value(const state& s, bool& game_over)
+    {
+        const int lines[8][3] = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}, {0, 3, 6}, {1, 4, 7}, {2, 5, 8}, {0, 4, 8}, {2, 4, 6}};
+
+        game_over = true;
+
+        for (const auto& line: lines)
+        {
+            int a = get_number(s, line[0]);
+            int b = get_number(s, line[1]);
+            int c = get_number(s, line[2]);
+
+            if (a != 0 && b != 0 && c != 0 && a + b + c == 15)
+            {
+                return -1; // whoever just moved filled it, so the player to move has lost.
+            }
+        }
+
+        if (s.number_of_pieces == 9)
+        {
+            return 0;
+        }
+
+        game_over = false;
+
+        return 0;
+    }
+
+    static uint64_t get_key(const state& s)
+    {
+        return s.squares | (uint64_t(s.comp_to_move) << 36);
+    }
+
+    static int get_number(const state& s, int square)
+    {
+        return (s.squares >> (4 * square)) & 15;
+    }
+};
+
+template <class Rules>
+class variant_solver
+{
+public:
+    typedef typename Rules::state state;
+
+    // Public methods:
+    int solve(const state& s); // returns 1, 0 or -1: the player to move wins, draws or loses with perfect play.
+    int find_best_move(const state& s); // returns one of the best moves for the player to move (-1 if there are none).
+
+    // Getters:
+    long long get_nodes_searched() const;
+    int get_number_of_solved_states() const;
+
+private:
+    unordered_map<uint64_t, signed char> solved; // the value of each state solved so far, by its key.
+    long long nodes_searched = 0;
+
+    // Private methods:
+    int negamax(const state& s);
+};
+
+// PUBLIC METHODS:
+
+template <class Rules>
+int variant_solver<Rules>::solve(const state& s)
+{
+    return negamax(s);
+}
+
+template <class Rules>
+int variant_solver<Rules>::find_best_move(const state& s)
+{
+    int moves[Rules::max_moves];
+    int count = Rules::generate_moves(s, moves);
+    int best_move = -1;
+    int best_value = -2;
+
+    for (int i = 0; i < count; i++)
+    {
+        state next = Rules::apply_move(s, moves[i]);
+        bool game_over;
+        int value = -Rules::get_value(next, game_over);
+
+        if (!game_over)
+        {
+            value = -negamax(next);
+        }
+
+        if (value > best_value)
+        {
+            best_value = value;
+            best_move = moves[i];
+        }
+    }
+
+    return best_move;
+}
+
+// GETTERS:
+
+template <class Rules>
+long long variant_solver<Rules>::get_nodes_searched() const
+{
+    return nodes_searched;
+}
+
+template <class Rules>
+int variant_solver<Rules>::get_number_of_solved_states() const
+{
+    return solved.size();
+}
+
+// PRIVATE METHODS:
+
+template <class Rules>
+int variant_solver<Rules>::negamax(const state& s)
+{
+    // s is never over (callers check that first), so it always has moves.
+
+    nodes_searched ++;
+
+    uint64_t key = Rules::get_key(s);
+
+    {
+        TRACE_SCOPE("solver_cache_probe");
+
+        auto found = solved.find(key);
+
+        if (found != solved.end())
+        {
+            return found->second;
+        }
+    }
+
+    int moves[Rules::max_moves];
+    int count = Rules::generate_moves(s, moves);
+    int best_value = -1;
+
+    for (int i = 0; i < count && best_value < 1; i++) // nothing beats a win, so stop once one is found.
+    {
+        state next = Rules::apply_move(s, moves[i]);
+        bool game_over;
+        int value = -Rules::get_value(next, game_over);
+
+        if (!game_over)
+        {
+            value = -negamax(next);
+        }
+
+        if (value > best_value)
+        {
+            best_value = value;
+        }
+    }
+
+    // Every value is exact (there's no alpha-beta window), so it's safe to remember it:
+
+    memory_scope scope(memory_cache);
+
+    solved[key] = best_value;
+
+    return best_value;
+}
@@ -0,0 +1,19 @@
+/* A "search_budget" says how much a search is allowed to spend before it has to answer with what it has.
+
+    - deadline: the search should stop once this time has passed.
+    - max_nodes: the search should stop after this many nodes (for Monte Carlo searches, playouts). 0 means no limit.
+
+   Every search that can stop early takes one of these, so callers can treat them all the same way.
+ */
+
+#pragma once
+
+#include <chrono>
+
+using namespace std;
+
+struct search_budget
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max(); // max() means no deadline.
+    long long max_nodes = 0; // 0 means no limit.
+};
@@ -0,0 +1,512 @@
+/* "threat_search" looks for a forced win on an mnk_board using nothing but threats, so on big boards (like gomoku) a
+   tactical win is found without searching every empty square like a full-width search does.
+
+    - A "window" is k squares in a row. The search keeps, for every window, how many pieces each side has in it, and
+      for each side how many windows it has with n pieces (and none of the other side's). Both are updated by
+      make_move() and undo_move(), which only touch the windows through the square played (at most 4k of them).
+      So "does this side have a four?" is one lookup, and the windows only need to be scanned when the answer is yes.
+    - A "four" is a window with k-1 of a side's pieces and nothing else, so its empty square wins. A "threat move" is a
+      move that makes two different winning squares at once, which can't both be blocked.
+    - The attacker only plays moves that make a four, or (when k is at least 4) a window with k-2 pieces that might
+      lead to a threat move. If the attacker has no four and no threat move after that, the line is dropped.
+    - The defender gets every move that could matter: the winning square when the attacker has a four, otherwise
+      every empty square of the attacker's k-2 windows, plus every move that makes a four of its own. Any other
+      reply leaves a threat move on the board, so leaving them out can't make a lost position look won.
+    - When the defender makes a four, the attacker has to block it before carrying on.
+    - max_threats limits how many attacking moves a line can have (tried with 0, 1, 2... of them, so the shortest wins
+      are found first), and the budget limits the whole search. Running out of either just means no win was found.
+ */
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <climits>
+
+#include "mnk_board.h"
+#include "search_budget.h"
+#include "tracing.h"
+
+using namespace std;
+
+struct threat_search_result
+{
+    bool found = false; // true if the attacker has a forced win.
+    int best_move = -1; // the first move of the win (-1 if none was found).
+    int plies = 0; // the win takes at most this many moves (counting both sides).
+    long long nodes = 0;
+    bool hit_budget = false; // true if the search stopped because the budget ran out.
+};
+
+class threat_search
+{
+public:
+    // Constructor:
+    threat_search(const mnk_board& boardP); // sets up the windows for boards of this size.
+
+    // Public methods:
+    threat_search_result find_forced_win(const mnk_board& boardP, bool attacker_is_compP, int max_threats,
+                                         const search_budget& budget); // boardP has to be the same size as the one
+                                                                       // given to the constructor.
+
+private:
+    struct window
+    {
+        int first_square;
+        int step; // how far apart the squares are (1 across, cols down, cols + 1 and cols - 1 for the diagonals).
+    };
+
+    mnk_board board;
+    int k;
+    vector<window> windows;
+    vector <vector<int>> windows_through_square; // indices into windows, for each square.
+    vector <vector<int>> pieces_in_window; // [window][side]: side 0 is the attacker, 1 the defender.
+    vector <vector<int>> open_windows; // [side][n]: how many windows have n of side's pieces, and none of the other's.
+    long long nodes = 0;
+    const search_budget* budget = nullptr; // only set during find_forced_win().
+    bool out_of_budget = false;
+    int root_move = -1;
+    vector<int> seen_stamps; // by square: the stamp of the last collect that added it (see new_stamp() below).
+    int stamp;
+
+    // Private methods:
+    void make_move(int square, int side);
+    void undo_move(int square, int side);
+    int find_winning_squares(int side, int squares[2]) const; // fills up to 2 of side's winning squares, and returns
+                                                              // how many it found.
+    int collect_window_squares(int side, int pieces, int squares[], int collect_stamp); // adds the empty squares of
+                                                                                       // side's windows with pieces
+                                                                                       // pieces in them (skipping any
+                                                                                       // already added with the same
+                                                                                       // collect_stamp).
+    int new_stamp(); // a stamp no square has yet, so every square counts as not added.
+    bool has_threat_move(); // returns true if the attacker can make two winning squares with one move.
+    int attacker_node(int threats_left, int ply); // returns how many plies the win takes, or 0 if none was found.
+    int defender_node(int threats_left, int ply);
+    bool is_budget_used_up();
+};
+
+// CONSTRUCTOR:
+
+inline threat_search::threat_search(const mnk_board& boardP): board(boardP)
+{
+    int rows = board.get_rows();
+    int cols = board.get_cols();
+
+    k = board.get_k();
+
+    windows_through_square.resize(board.get_number_of_squares());
+
+    // For each direction, every start square whose window stays on the board:
+
+    const int steps[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+    for (const auto& step: steps)
+    {
+        for (int row = 0; row < rows; row++)
+        {
+            for (int col = 0; col < cols; col++)
+            {
+                int last_row = row + (k - 1) * step[0];
+                int last_col = col + (k - 1) * step[1];
+
+                if (last_row >= rows || last_col < 0 || last_col >= cols)
+                {
+                    continue;
+                }
+
+                window w;
+
+                w.first_square = row * cols + col;
+                w.step = step[0] * cols + step[1];
+
+                for (int i = 0; i < k; i++)
+                {
+                    windows_through_square[w.first_square + i * w.step].push_back(windows.size());
+                }
+
+                windows.push_back(w);
+            }
+        }
+    }
+
+    pieces_in_window.assign(windows.size(), vector<int>(2, 0));
+    open_windows.assign(2, vector<int>(k + 1, 0));
+    seen_stamps.assign(board.get_number_of_squares(), 0);
+    stamp = 0;
+}
+
+// PUBLIC METHODS:
+
+inline threat_search_result threat_search::find_forced_win(const mnk_board& boardP, bool attacker_is_compP, int max_threats,
+                                                    const search_budget& budgetP)
+{
+    TRACE_SCOPE("threat_search");
+
+    threat_search_result result;
+
+    // Start from an empty board, and play boardP's pieces onto it, so the tables are filled in:
+
+    board = mnk_board(boardP.get_rows(), boardP.get_cols(), boardP.get_k());
+
+    for (vector<int>& counts: pieces_in_window)
+    {
+        counts[0] = 0;
+        counts[1] = 0;
+    }
+
+    open_windows[0].assign(k + 1, 0);
+    open_windows[1].assign(k + 1, 0);
+    open_windows[0][0] = windows.size();
+    open_windows[1][0] = windows.size();
+
+    for (int square = 0; square < boardP.get_number_of_squares(); square++)
+    {
+        if (!boardP.is_empty(square))
+        {
+            make_move(square, (boardP.get_square(square) == 'C') == attacker_is_compP ? 0 : 1);
+        }
+    }
+
+    nodes = 0;
+    budget = &budgetP;
+    out_of_budget = false;
+    root_move = -1;
+
+    // Iterative deepening on the number of threats, so short wins are found before the search wanders down long lines:
+
+    for (int threats = 0; threats <= max_threats && result.plies == 0 && !out_of_budget; threats++)
+    {
+        result.plies = attacker_node(threats, 0);
+    }
+
+    result.found = (result.plies != 0);
+    result.best_move = result.found ? root_move : -1;
+    result.nodes = nodes;
+    result.hit_budget = out_of_budget;
+
+    return result;
+}
+
+// PRIVATE METHODS:
+
+inline void threat_search::make_move(int square, int side)
+{
+    board.make_move(square, side == 0);
+
+    for (int w: windows_through_square[square])
+    {
+        vector<int>& counts = pieces_in_window[w];
+
+        // The window stops being open for the other side, and gets one more piece for this side (if it's still open
+        // for this side):
+
+        if (counts[side] == 0)
+        {
+            open_windows[1 - side][counts[1 - side]] --;
+        }
+
+        if (counts[1 - side] == 0)
+        {
+            open_windows[side][counts[side]] --;
+            open_windows[side][counts[side] + 1] ++;
+        }
+
+        counts[side] ++;
+    }
+}
+
+inline void threat_search::undo_move(int square, int side)
+{
+    board.undo_move(square);
+
+    for (int w: windows_through_square[square])
+    {
+        vector<int>& counts = pieces_in_window[w];
+
+        counts[side] --;
+
+        if (counts[1 - side] == 0)
+        {
+            open_windows[side][counts[side] + 1] --;
+            open_windows[side][counts[side]] ++;
+        }
+
+        if (counts[side] == 0)
+        {
+            open_windows[1 - side][counts[1 - side]] ++;
+        }
+    }
+}
+
+inline int threat_search::find_winning_squares(int side, int squares[2]) const
+{
+    if (open_windows[side][k - 1] == 0)
+    {
+        return 0;
+    }
+
+    int found = 0;
+
+    for (size_t w = 0; w < windows.size() && found < 2; w++)
+    {
+        if (pieces_in_window[w][side] != k - 1 || pieces_in_window[w][1 - side] != 0)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < k; i++)
+        {
+            int square = windows[w].first_square + i * windows[w].step;
+
+            if (board.is_empty(square) && (found == 0 || squares[0] != square))
+            {
+                squares[found++] = square;
+            }
+        }
+    }
+
+    return found;
+}
+
+inline int threat_search::collect_window_squares(int side, int pieces, int squares[], int collect_stamp)
+{
+    int count = 0;
+
+    if (pieces < 0 || open_windows[side][pieces] == 0)
+    {
+        return 0;
+    }
+
+    for (size_t w = 0; w < windows.size(); w++)
+    {
+        if (pieces_in_window[w][side] != pieces || pieces_in_window[w][1 - side] != 0)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < k; i++)
+        {
+            int square = windows[w].first_square + i * windows[w].step;
+
+            if (board.is_empty(square) && seen_stamps[square] != collect_stamp)
+            {
+                seen_stamps[square] = collect_stamp;
+                squares[count++] = square;
+            }
+        }
+    }
+
+    return count;
+}
+
+inline bool threat_search::has_threat_move()
+{
+    int candidates[mnk_board::max_squares];
+    int count = collect_window_squares(0, k - 2, candidates, new_stamp());
+
+    for (int i = 0; i < count; i++)
+    {
+        int winning_squares[2];
+
+        make_move(candidates[i], 0);
+
+        int found = find_winning_squares(0, winning_squares);
+
+        undo_move(candidates[i], 0);
+
+        if (found == 2)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline int threat_search::attacker_node(int threats_left, int ply)
+{
+    nodes ++;
+
+    if (is_budget_used_up())
+    {
+        return 0;
+    }
+
+    int winning_squares[2];
+
+    if (find_winning_squares(0, winning_squares) != 0)
+    {
+        if (ply == 0)
+        {
+            root_move = winning_squares[0];
+        }
+
+        return 1;
+    }
+
+    // If the defender has a four, it has to be blocked first (and two fours can't both be blocked):
+
+    int defender_wins = find_winning_squares(1, winning_squares);
+
+    if (defender_wins == 2)
+    {
+        return 0;
+    }
+
+    if (defender_wins == 1)
+    {
+        make_move(winning_squares[0], 0);
+
+        int plies = defender_node(threats_left, ply + 1);
+
+        undo_move(winning_squares[0], 0);
+
+        if (plies != 0 && ply == 0)
+        {
+            root_move = winning_squares[0];
+        }
+
+        return (plies == 0) ? 0 : plies + 1;
+    }
+
+    if (threats_left == 0)
+    {
+        return 0;
+    }
+
+    // Moves that make a four come first, since they leave the defender only one reply:
+
+    int moves[mnk_board::max_squares];
+    int collect_stamp = new_stamp();
+    int count = collect_window_squares(0, k - 2, moves, collect_stamp);
+
+    if (k >= 4)
+    {
+        count += collect_window_squares(0, k - 3, moves + count, collect_stamp);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        make_move(moves[i], 0);
+
+        int plies = defender_node(threats_left - 1, ply + 1);
+
+        undo_move(moves[i], 0);
+
+        if (plies != 0)
+        {
+            if (ply == 0)
+            {
+                root_move = moves[i];
+            }
+
+            return plies + 1;
+        }
+
+        if (out_of_budget)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+inline int threat_search::defender_node(int threats_left, int ply)
+{
+    nodes ++;
+
+    if (is_budget_used_up())
+    {
+        return 0;
+    }
+
+    int winning_squares[2];
+
+    if (find_winning_squares(1, winning_squares) != 0) // the defender wins first.
+    {
+        return 0;
+    }
+
+    int attacker_wins = find_winning_squares(0, winning_squares);
+
+    if (attacker_wins == 2)
+    {
+        return 2; // the defender blocks one, and the attacker plays the other.
+    }
+
+    int replies[mnk_board::max_squares];
+    int count;
+
+    if (attacker_wins == 1)
+    {
+        replies[0] = winning_squares[0];
+        count = 1;
+    }
+
+    else
+    {
+        if (!has_threat_move()) // the defender is free to play anywhere, so the attack has failed.
+        {
+            return 0;
+        }
+
+        int collect_stamp = new_stamp();
+
+        count = collect_window_squares(0, k - 2, replies, collect_stamp);
+        count += collect_window_squares(1, k - 2, replies + count, collect_stamp); // the defender's own fours.
+    }
+
+    int longest = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        make_move(replies[i], 1);
+
+        int plies = attacker_node(threats_left, ply + 1);
+
+        undo_move(replies[i], 1);
+
+        if (plies == 0) // this reply holds.
+        {
+            return 0;
+        }
+
+        longest = max(longest, plies);
+    }
+
+    return longest + 1;
+}
+
+inline int threat_search::new_stamp()
+{
+    // Every collect gets its own stamp, instead of clearing a "seen" array for each one. The moves are copied out before
+    // searching deeper, so it doesn't matter that deeper collects reuse seen_stamps. The stamps only wrap around after
+    // billions of collects, and then the array is cleared once:
+
+    if (stamp == INT_MAX)
+    {
+        seen_stamps.assign(seen_stamps.size(), 0);
+        stamp = 0;
+    }
+
+    return ++stamp;
+}
+
+inline bool threat_search::is_budget_used_up()
+{
+    if (budget->max_nodes != 0 && nodes >= budget->max_nodes)
+    {
+        out_of_budget = true;
+    }
+
+    // Reading the clock costs more than counting nodes, so it's only done every 1024 nodes:
+
+    if (!out_of_budget && (nodes & 1023) == 0 && chrono::steady_clock::now() >= budget->deadline)
+    {
+        out_of_budget = true;
+    }
+
+    return out_of_budget;
+}
@@ -0,0 +1,198 @@
+#include "tictactoe_api.h"
+
+#include <atomic>
+#include <vector>
+
+#include "position.h"
+#include "tracing.h"
+
+using namespace std;
+
+// Each entry packs a board's evaluation and best move into one byte: 0 means the board hasn't been evaluated yet,
+// otherwise it's 1 + (evaluation + 1) + 3 * (best move + 1). Being one atomic byte, an entry can be read while
+// another thread is filling in a different one (or the same one, with the same answer).
+
+struct ttt_engine
+{
+    vector <atomic<unsigned char>> entries; // indexed by get_key() below.
+
+    ttt_engine(): entries(1 << 19) {}
+};
+
+// HELPERS:
+
+static bool get_key(const char* board, bool is_comp_turn, unsigned int& key) // returns false if board isn't valid.
+{
+    unsigned int code = 0; // same layout as a bitboard.
+
+    for (int square = 0; square < 9; square++)
+    {
+        if (board[square] == 'C')
+        {
+            code |= 1u << square;
+        }
+
+        else if (board[square] == 'U')
+        {
+            code |= 1u << (9 + square);
+        }
+
+        else if (board[square] != ' ')
+        {
+            return false;
+        }
+    }
+
+    key = code * 2 + is_comp_turn;
+
+    return true;
+}
+
+static unsigned char search(const char* board, bool is_comp_turn) // returns a packed entry.
+{
+    vector <vector<char>> board_vector(3, vector<char>(3));
+    int pieces = 0;
+
+    for (int square = 0; square < 9; square++)
+    {
+        board_vector[square / 3][square % 3] = board[square];
+
+        if (board[square] != ' ')
+        {
+            pieces ++;
+        }
+    }
+
+    // Lazy, so all of the children get exact evaluations (no pruning) once it's expanded below. Nothing a search reads
+    // is changed by creating a position (even an empty board's), so searches can run on any number of threads at once,
+    // alongside the engine and the ponderer:
+
+    position p(board_vector, is_comp_turn, pieces, 100000, 100000, true);
+
+    int evaluation = p.get_evaluation();
+    int best_move = -1;
+
+    vector <unique_ptr<position>> children = p.get_future_positions();
+
+    for (const unique_ptr<position>& child: children)
+    {
+        if (child->get_evaluation() != evaluation)
+        {
+            continue;
+        }
+
+        const vector <vector<char>>& child_board = child->get_board();
+
+        for (int square = 0; square < 9 && best_move == -1; square++)
+        {
+            if (child_board[square / 3][square % 3] != board[square])
+            {
+                best_move = square;
+            }
+        }
+
+        break;
+    }
+
+    return 1 + (evaluation + 1) + 3 * (best_move + 1);
+}
+
+static bool evaluate_one(ttt_engine* engine, const char* board, bool is_comp_turn, int& evaluation, int& best_move)
+{
+    unsigned int key;
+
+    if (!get_key(board, is_comp_turn, key))
+    {
+        evaluation = 0;
+        best_move = -1;
+        return false;
+    }
+
+    unsigned char entry;
+
+    {
+        TRACE_SCOPE("api_cache_probe");
+
+        entry = engine->entries[key].load(memory_order_relaxed);
+    }
+
+    if (entry == 0)
+    {
+        try
+        {
+            entry = search(board, is_comp_turn);
+        }
+        catch (...) // e.g. bad_alloc. No exceptions can get out to a C caller.
+        {
+            evaluation = 0;
+            best_move = -1;
+            return false;
+        }
+
+        engine->entries[key].store(entry, memory_order_relaxed);
+    }
+
+    evaluation = (entry - 1) % 3 - 1;
+    best_move = (entry - 1) / 3 - 1;
+
+    return true;
+}
+
+// THE C INTERFACE:
+
+ttt_engine* ttt_engine_create(void)
+{
+    try
+    {
+        return new ttt_engine(); // no exceptions can get out to a C caller.
+    }
+    catch (...)
+    {
+        return NULL;
+    }
+}
+
+void ttt_engine_destroy(ttt_engine* engine)
+{
+    delete engine;
+}
+
+int ttt_evaluate(ttt_engine* engine, const char* board, int is_comp_turn, int* evaluation, int* best_move)
+{
+    int move;
+
+    if (!evaluate_one(engine, board, is_comp_turn != 0, *evaluation, move))
+    {
+        return -1;
+    }
+
+    if (best_move != NULL)
+    {
+        *best_move = move;
+    }
+
+    return 0;
+}
+
+int ttt_evaluate_batch(ttt_engine* engine, const char* boards, const unsigned char* is_comp_turn, size_t count,
+                       int* evaluations, int* best_moves)
+{
+    int result = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int move;
+
+        if (!evaluate_one(engine, boards + 9 * i, is_comp_turn[i] != 0, evaluations[i], move))
+        {
+            result = -1;
+        }
+
+        if (best_moves != NULL)
+        {
+            best_moves[i] = move;
+        }
+    }
+
+    return result;
+}
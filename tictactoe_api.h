@@ -0,0 +1,50 @@
+/* A plain C interface to the engine, so it can be built as a shared library and called from other languages.
+
+    - A board is 9 chars, row by row: 'C' for the computer's pieces, 'U' for the user's, and ' ' for empty squares.
+      So board[row * 3 + col] is the square at [row][col].
+    - An evaluation is the same as position's: +1 if the computer wins with perfect play, 0 for a draw, and -1 if the
+      user wins.
+    - A move is a square number (row * 3 + col), or -1 if the game is already over.
+    - The engine remembers every board it has evaluated, so asking about the same board again (from any call) is
+      just a table lookup.
+    - ttt_evaluate_batch() reads straight out of the caller's buffers and writes straight into the caller's arrays.
+      Nothing is copied, and nothing is allocated once the boards have been seen before.
+    - Functions return 0 on success, and -1 if a board isn't valid (a char other than 'C', 'U' or ' '), or if the
+      engine ran out of memory evaluating it.
+    - Calls on the same engine (or on different engines) can come from different threads.
+ */
+
+#ifndef TICTACTOE_API_H
+#define TICTACTOE_API_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+    #define TTT_API __declspec(dllexport)
+#else
+    #define TTT_API __attribute__((visibility("default")))
+#endif
+
+typedef struct ttt_engine ttt_engine;
+
+TTT_API ttt_engine* ttt_engine_create(void); /* returns NULL if it couldn't be created. */
+TTT_API void ttt_engine_destroy(ttt_engine* engine);
+
+/* Evaluates one board. is_comp_turn is non-zero if it's the computer's turn. best_move can be NULL. */
+TTT_API int ttt_evaluate(ttt_engine* engine, const char* board, int is_comp_turn, int* evaluation, int* best_move);
+
+/* Evaluates count boards, stored one after another in boards (so 9 * count chars). is_comp_turn has count entries.
+   evaluations (and best_moves, unless it's NULL) get count entries written into them. If a board isn't valid, its
+   entries are set to 0 and -1, the rest are still evaluated, and -1 is returned. */
+TTT_API int ttt_evaluate_batch(ttt_engine* engine, const char* boards, const unsigned char* is_comp_turn, size_t count,
+                               int* evaluations, int* best_moves);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+#include "tracing.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+
+// TRACING:
+
+bool tracing::is_enabled()
+{
+#ifdef ENGINE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void tracing::record(const char* name, bool is_begin)
+{
+    trace_buffer& buffer = get_thread_buffer();
+
+    trace_event& event = buffer.events[buffer.events_recorded % events_per_thread];
+
+    event.name = name;
+    event.nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    event.is_begin = is_begin;
+
+    buffer.events_recorded ++;
+}
+
+void tracing::clear()
+{
+    lock_guard<mutex> lock(get_buffers_mutex());
+
+    for (const shared_ptr<trace_buffer>& buffer: get_buffers())
+    {
+        buffer->events_recorded = 0;
+    }
+}
+
+long long tracing::get_events_recorded()
+{
+    lock_guard<mutex> lock(get_buffers_mutex());
+
+    long long total = 0;
+
+    for (const shared_ptr<trace_buffer>& buffer: get_buffers())
+    {
+        total += buffer->events_recorded;
+    }
+
+    return total;
+}
+
+void tracing::write_folded_stacks(ostream& out)
+{
+    lock_guard<mutex> lock(get_buffers_mutex());
+
+    map<string, long long> self_times; // by stack, e.g. "minimax;construct_child;minimax".
+
+    for (const shared_ptr<trace_buffer>& buffer: get_buffers())
+    {
+        vector<trace_event> events = get_events_in_order(*buffer);
+
+        // Walk the events with a stack of open scopes. The time between one event and the next belongs to whatever
+        // scope is on top of the stack:
+
+        vector<const char*> stack;
+        string stack_name;
+        vector<size_t> stack_name_lengths; // the length of stack_name before each scope was added to it.
+
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            if (i > 0 && !stack.empty())
+            {
+                self_times[stack_name] += events[i].nanoseconds - events[i - 1].nanoseconds;
+            }
+
+            if (events[i].is_begin)
+            {
+                stack_name_lengths.push_back(stack_name.size());
+                stack_name += (stack.empty() ? "" : ";") + string(events[i].name);
+                stack.push_back(events[i].name);
+            }
+
+            else if (!stack.empty()) // an end with no begin means the begin was written over, so it's skipped.
+            {
+                stack.pop_back();
+                stack_name.resize(stack_name_lengths.back());
+                stack_name_lengths.pop_back();
+            }
+        }
+    }
+
+    for (const auto& entry: self_times)
+    {
+        out << entry.first << " " << entry.second << "\n";
+    }
+}
+
+void tracing::write_chrome_trace(ostream& out)
+{
+    lock_guard<mutex> lock(get_buffers_mutex());
+
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    for (const shared_ptr<trace_buffer>& buffer: get_buffers())
+    {
+        for (const trace_event& event: get_events_in_order(*buffer))
+        {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"" << (event.is_begin ? "B" : "E")
+                << "\",\"ts\":" << event.nanoseconds / 1000 << "." << (event.nanoseconds % 1000) / 100 // microseconds.
+                << ",\"pid\":1,\"tid\":" << buffer->thread_number << "}";
+
+            first = false;
+        }
+    }
+
+    out << "\n]}\n";
+}
+
+trace_buffer& tracing::get_thread_buffer()
+{
+    thread_local shared_ptr<trace_buffer> buffer;
+
+    if (buffer == nullptr) // this thread's first event.
+    {
+        buffer = make_shared<trace_buffer>();
+        buffer->events.resize(events_per_thread);
+
+        lock_guard<mutex> lock(get_buffers_mutex());
+
+        buffer->thread_number = get_buffers().size() + 1;
+        get_buffers().push_back(buffer);
+    }
+
+    return *buffer;
+}
+
+vector <shared_ptr<trace_buffer>>& tracing::get_buffers()
+{
+    static vector <shared_ptr<trace_buffer>> buffers;
+
+    return buffers;
+}
+
+mutex& tracing::get_buffers_mutex()
+{
+    static mutex buffers_mutex;
+
+    return buffers_mutex;
+}
+
+vector<trace_event> tracing::get_events_in_order(const trace_buffer& buffer)
+{
+    vector<trace_event> events;
+
+    long long first = (buffer.events_recorded > events_per_thread) ? buffer.events_recorded - events_per_thread : 0;
+
+    for (long long i = first; i < buffer.events_recorded; i++)
+    {
+        events.push_back(buffer.events[i % events_per_thread]);
+    }
+
+    return events;
+}
+
+// TRACE_SCOPE:
+
+trace_scope::trace_scope(const char* nameP)
+{
+    name = nameP;
+
+    tracing::record(name, true);
+}
+
+trace_scope::~trace_scope()
+{
+    tracing::record(name, false);
+}
@@ -0,0 +1,81 @@
+/* "tracing" records when the engine's hot paths start and finish, so it's possible to see where a search spends its
+   time without attaching a profiler.
+
+    - Only switched on when ENGINE_TRACING is defined (e.g. -DENGINE_TRACING), like memory_stats is with
+      MEMORY_ACCOUNTING. Otherwise, TRACE_SCOPE() is empty and nothing in here costs anything.
+    - TRACE_SCOPE("name") at the start of a block records a begin event there, and an end event when the block ends.
+      Times come from steady_clock, in nanoseconds.
+    - Each thread writes into its own ring buffer (events_per_thread events), so recording never takes a lock. When a
+      buffer is full, the oldest events are written over.
+    - write_folded_stacks() gives one line per call stack with the time spent in it (not counting its callees), in the
+      format flame graph tools read ("minimax;construct_child;minimax 12345").
+    - write_chrome_trace() gives JSON that chrome://tracing (or Perfetto) can open.
+    - Export after the traced work has finished, since the buffers aren't locked while threads write to them.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+using namespace std;
+
+#ifdef ENGINE_TRACING
+    #define TRACE_CONCATENATE_INNER(a, b) a##b
+    #define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_INNER(a, b)
+    #define TRACE_SCOPE(name) trace_scope TRACE_CONCATENATE(trace_scope_, __LINE__)(name)
+#else
+    #define TRACE_SCOPE(name)
+#endif
+
+struct trace_event
+{
+    const char* name; // always a string literal, so only the pointer needs to be kept.
+    long long nanoseconds; // since the steady_clock's epoch.
+    bool is_begin;
+};
+
+struct trace_buffer
+{
+    vector<trace_event> events; // a ring: event i is at index i % events.size().
+    long long events_recorded = 0; // including any that have been written over.
+    int thread_number; // 1 for the first thread that recorded something, and so on.
+};
+
+class tracing
+{
+public:
+    static const int events_per_thread = 1 << 18;
+
+    // Public static methods:
+    static bool is_enabled(); // returns true if the program was built with ENGINE_TRACING.
+    static void record(const char* name, bool is_begin); // adds an event to this thread's buffer.
+    static void clear(); // throws away every event recorded so far, on every thread.
+    static long long get_events_recorded(); // all threads together, including any that have been written over.
+    static void write_folded_stacks(ostream& out);
+    static void write_chrome_trace(ostream& out);
+
+private:
+    // Private static methods:
+    static vector <shared_ptr<trace_buffer>>& get_buffers(); // every thread's buffer. Kept here, so they outlive their
+                                                             // threads. A function rather than a static variable, since
+                                                             // events can be recorded while static variables are still
+                                                             // being initialized (e.g. by bitboard's table).
+    static mutex& get_buffers_mutex(); // guards get_buffers() (only locked when a thread records its first event, or
+                                       // to export).
+    static trace_buffer& get_thread_buffer();
+    static vector<trace_event> get_events_in_order(const trace_buffer& buffer); // oldest first.
+};
+
+class trace_scope
+{
+public:
+    // Constructor & destructor:
+    trace_scope(const char* nameP); // records a begin event...
+    ~trace_scope(); // ...and an end event.
+
+private:
+    const char* name;
+};
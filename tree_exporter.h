@@ -0,0 +1,259 @@
+/* A "tree_exporter" writes out the whole game tree under a board, without ever holding the tree in memory.
+
+    - It does a depth first search (with no pruning, so every score is exact), and writes each node as soon as its
+      score is known. Only the boards on the current line of play are kept around, so memory depends on the depth of
+      the tree, not its size.
+    - Output is collected in one big buffer, which is written to the stream only when it fills up (and at the end).
+    - Node ids are given out in the order nodes are first reached (the root is 0), and each node records its parent's
+      id (-1 for the root). Since a node is written after its children, parents come after their children in the output.
+
+   Formats:
+
+    - export_binary: 16 bytes per node, all little endian:
+        bytes 0-3: id, bytes 4-7: parent id, bytes 8-11: board (as a bitboard, see bitboard.h),
+        byte 12: depth, byte 13: 1 if it's the computer's turn (else 0), byte 14: score (-1, 0 or +1), byte 15: unused.
+    - export_text: one line per node, with the fields separated by spaces:
+        id parent_id board side depth score
+      where board is 9 characters ('C', 'U' or '.' for empty, row by row) and side is C or U (whose turn it is).
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "position.h"
+#include "bitboard.h"
+
+using namespace std;
+
+enum export_format
+{
+    export_binary,
+    export_text
+};
+
+class tree_exporter
+{
+public:
+    // Constructor & destructor:
+    tree_exporter(ostream& outP, export_format formatP, int buffer_sizeP = 1 << 20); // buffer_sizeP is in bytes.
+    ~tree_exporter(); // writes out whatever is still in the buffer.
+
+    // Public methods:
+    int export_tree(const vector <vector<char>>& boardP, bool turnP); // writes every node of the tree under boardP,
+                                                                      // and returns the score of boardP.
+    void flush(); // writes the buffer to the stream, and empties it.
+
+    // Getters:
+    long long get_nodes_written() const;
+
+private:
+    ostream& out;
+    export_format format;
+    vector <char> buffer; // never grows past its starting size.
+    int buffer_used; // stores how many bytes of buffer are filled.
+    long long next_id; // stores the id the next node reached will get.
+    long long nodes_written;
+
+    // Private methods:
+    int visit(unsigned int code, bool is_comp_turn, long long parent_id); // exports the node and everything under it,
+                                                                          // and returns its score.
+    void write_node(long long id, long long parent_id, unsigned int code, bool is_comp_turn, int score);
+    void write_binary_int(long long value); // 4 bytes, little endian.
+    void write_text_int(long long value);
+    void make_room(int bytes); // flushes if there are fewer than bytes bytes left in the buffer.
+};
+
+// CONSTRUCTOR & DESTRUCTOR:
+
+inline tree_exporter::tree_exporter(ostream& outP, export_format formatP, int buffer_sizeP) : out(outP)
+{
+    format = formatP;
+    buffer.resize(buffer_sizeP < 64 ? 64 : buffer_sizeP); // has to fit at least one node.
+    buffer_used = 0;
+    next_id = 0;
+    nodes_written = 0;
+}
+
+inline tree_exporter::~tree_exporter()
+{
+    flush();
+}
+
+// PUBLIC METHODS:
+
+inline int tree_exporter::export_tree(const vector <vector<char>>& boardP, bool turnP)
+{
+    next_id = 0;
+
+    int score = visit(bitboard::encode(boardP), turnP, -1);
+
+    flush();
+
+    return score;
+}
+
+inline void tree_exporter::flush()
+{
+    out.write(buffer.data(), buffer_used);
+
+    buffer_used = 0;
+}
+
+// GETTERS:
+
+inline long long tree_exporter::get_nodes_written() const
+{
+    return nodes_written;
+}
+
+// PRIVATE METHODS:
+
+inline int tree_exporter::visit(unsigned int code, bool is_comp_turn, long long parent_id)
+{
+    long long id = next_id;
+
+    next_id ++;
+
+    // Is the game over? (Same rules as position: only the side that just moved can have won.)
+
+    int score = 100; // stays 100 if the game isn't over.
+
+    if (!is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_comp_pieces(code)))
+    {
+        score = 1;
+    }
+
+    else if (is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_user_pieces(code)))
+    {
+        score = -1;
+    }
+
+    else if (bitboard::get_empty_squares(code) == 0)
+    {
+        score = 0;
+    }
+
+    if (score == 100) // not over, so visit every position one move ahead:
+    {
+        int shift = is_comp_turn ? 0 : 9;
+
+        for (int square = 0; square < 9; square++)
+        {
+            if (bitboard::get_empty_squares(code) & (1u << square))
+            {
+                int future_score = visit(code | (1u << (shift + square)), !is_comp_turn, id);
+
+                if (score == 100 || (is_comp_turn && future_score > score) || (!is_comp_turn && future_score < score))
+                {
+                    score = future_score;
+                }
+            }
+        }
+    }
+
+    write_node(id, parent_id, code, is_comp_turn, score);
+
+    return score;
+}
+
+inline void tree_exporter::write_node(long long id, long long parent_id, unsigned int code, bool is_comp_turn, int score)
+{
+    make_room(64); // more than a node ever needs, in either format.
+
+    int depth = bitboard::count_pieces(code);
+
+    if (format == export_binary)
+    {
+        write_binary_int(id);
+        write_binary_int(parent_id);
+        write_binary_int(code);
+
+        buffer[buffer_used++] = static_cast<char>(depth);
+        buffer[buffer_used++] = is_comp_turn ? 1 : 0;
+        buffer[buffer_used++] = static_cast<char>(score);
+        buffer[buffer_used++] = 0;
+    }
+
+    else
+    {
+        write_text_int(id);
+        buffer[buffer_used++] = ' ';
+        write_text_int(parent_id);
+        buffer[buffer_used++] = ' ';
+
+        for (int square = 0; square < 9; square++)
+        {
+            if (bitboard::get_comp_pieces(code) & (1u << square))
+            {
+                buffer[buffer_used++] = 'C';
+            }
+
+            else if (bitboard::get_user_pieces(code) & (1u << square))
+            {
+                buffer[buffer_used++] = 'U';
+            }
+
+            else
+            {
+                buffer[buffer_used++] = '.';
+            }
+        }
+
+        buffer[buffer_used++] = ' ';
+        buffer[buffer_used++] = is_comp_turn ? 'C' : 'U';
+        buffer[buffer_used++] = ' ';
+        write_text_int(depth);
+        buffer[buffer_used++] = ' ';
+        write_text_int(score);
+        buffer[buffer_used++] = '\n';
+    }
+
+    nodes_written ++;
+}
+
+inline void tree_exporter::write_binary_int(long long value)
+{
+    unsigned int bits = static_cast<unsigned int>(value); // so -1 comes out as 0xFFFFFFFF.
+
+    for (int i = 0; i < 4; i++)
+    {
+        buffer[buffer_used++] = static_cast<char>((bits >> (8 * i)) & 255);
+    }
+}
+
+inline void tree_exporter::write_text_int(long long value)
+{
+    if (value < 0)
+    {
+        buffer[buffer_used++] = '-';
+        value = -value;
+    }
+
+    // Write the digits backwards into a small array, then copy them over in the right order:
+
+    char digits[20];
+    int count = 0;
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+
+    while (count > 0)
+    {
+        buffer[buffer_used++] = digits[--count];
+    }
+}
+
+inline void tree_exporter::make_room(int bytes)
+{
+    if (buffer_used + bytes > static_cast<int>(buffer.size()))
+    {
+        flush();
+    }
+}
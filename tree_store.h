@@ -0,0 +1,206 @@
+/* A "tree_store" holds a whole game tree in a few flat arrays, for analysis code that walks the tree over and over.
+
+    - Node i's board (as a bitboard), score, first child and number of children are at index i of each array. There
+      are no pointers: a node's children are the child_count nodes starting at index first_child.
+    - Nodes are stored breadth first, so the root is node 0, then every node one move ahead, and so on. Walking the
+      tree level by level is just reading the arrays from start to end.
+    - Unlike a position, nothing is pruned: the tree has every reachable position, and every score is exact
+      (-1, 0 or +1, with the same meaning as position's evaluation).
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "position.h"
+#include "bitboard.h"
+#include "memory_stats.h"
+
+using namespace std;
+
+class tree_store
+{
+public:
+    // Constructor:
+    tree_store(); // makes an empty store. Call build() to fill it.
+
+    // Public methods:
+    void build(const vector <vector<char>>& boardP, bool turnP); // replaces the store with the full game tree under
+                                                                 // boardP, where turnP is true if it's the
+                                                                 // computer's turn.
+
+    template <class Visitor>
+    void for_each_breadth_first(Visitor visit) const; // calls visit(i) for every node i, in breadth first order.
+
+    // Getters:
+    int get_size() const; // returns the number of nodes.
+    unsigned int get_board_code(int i) const;
+    vector <vector<char>> get_board(int i) const;
+    int get_score(int i) const;
+    int get_first_child(int i) const;
+    int get_child_count(int i) const;
+    int get_depth(int i) const; // the number of pieces on node i's board.
+    bool get_is_comp_turn(int i) const;
+
+private:
+    vector <unsigned int> board_codes; // stores each node's board as a bitboard.
+    vector <signed char> scores; // stores each node's score.
+    vector <int> first_children; // stores the index of each node's first child (or -1 if it has none).
+    vector <unsigned char> child_counts; // stores how many children each node has.
+    bool root_is_comp_turn; // stores true if it's the computer's turn at the root.
+    int root_depth; // stores the number of pieces on the root's board.
+};
+
+// CONSTRUCTOR:
+
+inline tree_store::tree_store()
+{
+    root_is_comp_turn = true;
+    root_depth = 0;
+}
+
+// PUBLIC METHODS:
+
+inline void tree_store::build(const vector <vector<char>>& boardP, bool turnP)
+{
+    memory_scope scope(memory_nodes);
+
+    board_codes.clear();
+    scores.clear();
+    first_children.clear();
+    child_counts.clear();
+
+    root_is_comp_turn = turnP;
+    root_depth = bitboard::count_pieces(bitboard::encode(boardP));
+
+    board_codes.push_back(bitboard::encode(boardP));
+
+    // First pass: add nodes level by level. Since the arrays themselves are in breadth first order, they double as
+    // the queue: node i's children get added to the end while node i is being looked at.
+
+    for (size_t i = 0; i < board_codes.size(); i++)
+    {
+        unsigned int code = board_codes[i];
+        bool is_comp_turn = get_is_comp_turn(i);
+        signed char score = 100; // stays 100 if the game isn't over, until the second pass below.
+
+        // Same rules as position::did_computer_win() and did_opponent_win(): only the side that just moved can have won.
+
+        if (!is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_comp_pieces(code)))
+        {
+            score = 1;
+        }
+
+        else if (is_comp_turn && bitboard::is_three_in_a_row(bitboard::get_user_pieces(code)))
+        {
+            score = -1;
+        }
+
+        else if (bitboard::get_empty_squares(code) == 0)
+        {
+            score = 0;
+        }
+
+        scores.push_back(score);
+
+        if (score != 100) // game over, so no children.
+        {
+            first_children.push_back(-1);
+            child_counts.push_back(0);
+            continue;
+        }
+
+        first_children.push_back(board_codes.size());
+
+        int shift = is_comp_turn ? 0 : 9; // where the piece of the side to move goes in the bitboard.
+        int count = 0;
+
+        for (int square = 0; square < 9; square++)
+        {
+            if (bitboard::get_empty_squares(code) & (1u << square))
+            {
+                board_codes.push_back(code | (1u << (shift + square)));
+                count ++;
+            }
+        }
+
+        child_counts.push_back(count);
+    }
+
+    // Second pass: children always come after their parent, so going backwards means every child already has its
+    // score by the time its parent is looked at.
+
+    for (int i = board_codes.size() - 1; i >= 0; i--)
+    {
+        if (child_counts[i] == 0)
+        {
+            continue;
+        }
+
+        bool is_comp_turn = get_is_comp_turn(i);
+        signed char best = scores[first_children[i]];
+
+        for (int child = first_children[i] + 1; child < first_children[i] + child_counts[i]; child++)
+        {
+            if ((is_comp_turn && scores[child] > best) || (!is_comp_turn && scores[child] < best))
+            {
+                best = scores[child];
+            }
+        }
+
+        scores[i] = best;
+    }
+}
+
+template <class Visitor>
+void tree_store::for_each_breadth_first(Visitor visit) const
+{
+    for (size_t i = 0; i < board_codes.size(); i++)
+    {
+        visit(i);
+    }
+}
+
+// GETTERS:
+
+inline int tree_store::get_size() const
+{
+    return board_codes.size();
+}
+
+inline unsigned int tree_store::get_board_code(int i) const
+{
+    return board_codes[i];
+}
+
+inline vector <vector<char>> tree_store::get_board(int i) const
+{
+    return bitboard::decode(board_codes[i]);
+}
+
+inline int tree_store::get_score(int i) const
+{
+    return scores[i];
+}
+
+inline int tree_store::get_first_child(int i) const
+{
+    return first_children[i];
+}
+
+inline int tree_store::get_child_count(int i) const
+{
+    return child_counts[i];
+}
+
+inline int tree_store::get_depth(int i) const
+{
+    return bitboard::count_pieces(board_codes[i]);
+}
+
+inline bool tree_store::get_is_comp_turn(int i) const
+{
+    // The side to move flips with every piece added since the root:
+
+    return ((get_depth(i) - root_depth) % 2 == 0) ? root_is_comp_turn : !root_is_comp_turn;
+}
@@ -0,0 +1,7 @@
+#include "ultimate.h"
+
+// Initializing the static variables:
+
+vector<char> ultimate_engine::outcome_table = create_outcome_table();
+
+vector<short> ultimate_engine::score_table = create_score_table();
@@ -0,0 +1,535 @@
+/* "ultimate" plays ultimate tic-tac-toe: a 3x3 grid of normal 3x3 boards ("sub-boards").
+
+   Rules:
+    - The square you play in (0-8) picks the sub-board your opponent has to play in next. If that sub-board is already
+      won or full, they can play in any open sub-board.
+    - Getting 3-in-a-row in a sub-board wins it. Winning 3 sub-boards in a row wins the game. If every sub-board is
+      closed (won or full) with no such line, the game is drawn.
+
+   Encoding:
+    - Each sub-board is a bitboard (see bitboard.h): the computer's 9-bit mask and the user's 9-bit mask. So an
+      ultimate_state is 9 small masks, plus masks of which sub-boards each side has won, which sub-board is forced,
+      and whose turn it is. Copying one is as cheap as copying a few ints, so the search copies instead of undoing moves.
+    - A move is sub_board * 9 + square (0-80).
+    - Every possible sub-board (all 2^18 bitboards) is looked up in tables made once at startup: one for the outcome
+      (open, won by either side, or full), and one for a heuristic score. Both come from bitboard's 3-in-a-row table,
+      which is built from position::three_in_a_row(). The same tables are used for the big 3x3 grid of sub-boards.
+
+   Search: iterative deepening alpha-beta (negamax), with a transposition table, that stops when its search_budget
+   runs out and returns the best move of the last depth it finished.
+ */
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include "bitboard.h"
+#include "search_budget.h"
+#include "memory_stats.h"
+
+using namespace std;
+
+struct ultimate_state
+{
+    unsigned short comp_squares[9]; // the computer's 9-bit mask in each sub-board.
+    unsigned short user_squares[9]; // the user's 9-bit mask in each sub-board.
+    unsigned short comp_boards; // 9-bit mask of the sub-boards the computer has won.
+    unsigned short user_boards; // 9-bit mask of the sub-boards the user has won.
+    unsigned short closed_boards; // 9-bit mask of the sub-boards that are won or full.
+    signed char forced_board; // the sub-board the side to move has to play in, or -1 if they can play in any.
+    bool comp_to_move;
+};
+
+struct ultimate_search_result
+{
+    int best_move = -1; // sub_board * 9 + square, or -1 if the game is over.
+    int score = 0; // from the point of view of the side to move.
+    int depth = 0; // the deepest search that finished.
+    long long nodes = 0;
+};
+
+class ultimate_engine
+{
+public:
+    static const int win_score = 1000000; // a won game scores this minus the number of moves it takes.
+
+    // Public static methods:
+    static ultimate_state create_start_state(bool comp_firstP);
+    static int generate_moves(const ultimate_state& state, int moves[81]); // fills moves, and returns how many there are.
+    static ultimate_state apply_move(const ultimate_state& state, int move);
+    static int get_outcome(const ultimate_state& state); // 0 if the game isn't over, 1 if the computer won, 2 if the
+                                                         // user won, 3 if it's a draw.
+    static int evaluate(const ultimate_state& state); // heuristic score from the computer's point of view.
+    static uint64_t hash(const ultimate_state& state);
+    static ultimate_search_result search(const ultimate_state& state, const search_budget& budget); // the budget has
+                                                                                                    // to have a
+                                                                                                    // deadline or
+                                                                                                    // max_nodes.
+
+    static vector<char> create_outcome_table(); // creates outcome_table below.
+    static vector<short> create_score_table(); // creates score_table below.
+
+    // Public static variable(s):
+    static vector<char> outcome_table; // for each bitboard: 0 open, 1 computer won, 2 user won, 3 full with no winner.
+    static vector<short> score_table; // for each bitboard: how good it looks for the computer (negative = for the user).
+
+private:
+    struct table_entry
+    {
+        uint64_t key;
+        int score;
+        signed char depth;
+        signed char bound; // 0 exact, 1 lower bound, 2 upper bound.
+        signed char best_move;
+    };
+
+    // Private static methods:
+    static int negamax(const ultimate_state& state, int depth, int alpha, int beta, int ply, vector<table_entry>& table,
+                       long long& nodes, const search_budget& budget, bool& out_of_budget);
+};
+
+// The static variables are initialized in ultimate.cpp, so that this header can be included by more than one
+// translation unit.
+
+// PUBLIC STATIC METHODS:
+
+inline ultimate_state ultimate_engine::create_start_state(bool comp_firstP)
+{
+    ultimate_state state;
+
+    for (int b = 0; b < 9; b++)
+    {
+        state.comp_squares[b] = 0;
+        state.user_squares[b] = 0;
+    }
+
+    state.comp_boards = 0;
+    state.user_boards = 0;
+    state.closed_boards = 0;
+    state.forced_board = -1;
+    state.comp_to_move = comp_firstP;
+
+    return state;
+}
+
+inline int ultimate_engine::generate_moves(const ultimate_state& state, int moves[81])
+{
+    int count = 0;
+
+    int first_board = state.forced_board == -1 ? 0 : state.forced_board;
+    int last_board = state.forced_board == -1 ? 8 : state.forced_board;
+
+    for (int b = first_board; b <= last_board; b++)
+    {
+        if (state.closed_boards & (1 << b))
+        {
+            continue;
+        }
+
+        unsigned int empty = ~(state.comp_squares[b] | state.user_squares[b]) & 511;
+
+        for (int square = 0; square < 9; square++)
+        {
+            if (empty & (1u << square))
+            {
+                moves[count++] = b * 9 + square;
+            }
+        }
+    }
+
+    return count;
+}
+
+inline ultimate_state ultimate_engine::apply_move(const ultimate_state& state, int move)
+{
+    ultimate_state next = state;
+
+    int b = move / 9;
+    int square = move % 9;
+
+    if (state.comp_to_move)
+    {
+        next.comp_squares[b] |= 1 << square;
+    }
+
+    else
+    {
+        next.user_squares[b] |= 1 << square;
+    }
+
+    int outcome = outcome_table[next.comp_squares[b] | (next.user_squares[b] << 9)];
+
+    if (outcome == 1)
+    {
+        next.comp_boards |= 1 << b;
+    }
+
+    else if (outcome == 2)
+    {
+        next.user_boards |= 1 << b;
+    }
+
+    if (outcome != 0)
+    {
+        next.closed_boards |= 1 << b;
+    }
+
+    next.forced_board = (next.closed_boards & (1 << square)) ? -1 : square;
+    next.comp_to_move = !state.comp_to_move;
+
+    return next;
+}
+
+inline int ultimate_engine::get_outcome(const ultimate_state& state)
+{
+    if (bitboard::is_three_in_a_row(state.comp_boards))
+    {
+        return 1;
+    }
+
+    if (bitboard::is_three_in_a_row(state.user_boards))
+    {
+        return 2;
+    }
+
+    if (state.closed_boards == 511)
+    {
+        return 3;
+    }
+
+    return 0;
+}
+
+inline int ultimate_engine::evaluate(const ultimate_state& state)
+{
+    int score = 0;
+
+    for (int b = 0; b < 9; b++)
+    {
+        int weight = (b == 4) ? 3 : ((b % 2 == 0) ? 2 : 1); // the center sub-board is in the most lines, then corners.
+
+        if (state.comp_boards & (1 << b))
+        {
+            score += 100 * weight;
+        }
+
+        else if (state.user_boards & (1 << b))
+        {
+            score -= 100 * weight;
+        }
+
+        else if (!(state.closed_boards & (1 << b)))
+        {
+            score += score_table[state.comp_squares[b] | (state.user_squares[b] << 9)] * weight;
+        }
+    }
+
+    // The big grid is scored with the same table, as if each won sub-board were a piece:
+
+    score += 60 * score_table[state.comp_boards | (state.user_boards << 9)];
+
+    return score;
+}
+
+inline uint64_t ultimate_engine::hash(const ultimate_state& state)
+{
+    uint64_t h = state.comp_to_move ? 0x9E3779B97F4A7C15ULL : 0x7F4A7C159E3779B9ULL;
+
+    for (int b = 0; b < 9; b++)
+    {
+        h ^= (uint64_t(state.comp_squares[b]) | (uint64_t(state.user_squares[b]) << 9)) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    }
+
+    h ^= uint64_t(state.forced_board + 1) * 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 29;
+
+    return h;
+}
+
+inline ultimate_search_result ultimate_engine::search(const ultimate_state& state, const search_budget& budget)
+{
+    ultimate_search_result result;
+
+    int moves[81];
+
+    if (get_outcome(state) != 0 || generate_moves(state, moves) == 0)
+    {
+        return result;
+    }
+
+    vector<table_entry> table;
+
+    {
+        memory_scope scope(memory_cache);
+
+        table.resize(1 << 20); // 16 MB.
+    }
+
+    bool out_of_budget = false;
+    int count = generate_moves(state, moves);
+
+    for (int depth = 1; depth <= 81; depth++)
+    {
+        int alpha = -win_score - 1;
+        int best_move = -1;
+
+        // The root's moves are searched here (not in negamax), so the best move can't get lost in the table:
+
+        for (int i = 0; i < count; i++)
+        {
+            int score = -negamax(apply_move(state, moves[i]), depth - 1, -win_score - 1, -alpha, 1, table, result.nodes,
+                                 budget, out_of_budget);
+
+            if (out_of_budget)
+            {
+                break;
+            }
+
+            if (score > alpha)
+            {
+                alpha = score;
+                best_move = i;
+            }
+        }
+
+        if (out_of_budget) // this depth didn't finish, so stick with the last one that did.
+        {
+            break;
+        }
+
+        result.best_move = moves[best_move];
+        result.score = alpha;
+        result.depth = depth;
+
+        // Search this depth's best move first next time:
+
+        int temp = moves[best_move];
+        moves[best_move] = moves[0];
+        moves[0] = temp;
+
+        if (alpha >= win_score - 81 || alpha <= -win_score + 81) // the game is decided, so searching deeper won't help.
+        {
+            break;
+        }
+    }
+
+    if (result.best_move == -1) // not even depth 1 finished, so any legal move will have to do.
+    {
+        result.best_move = moves[0];
+    }
+
+    return result;
+}
+
+inline vector<char> ultimate_engine::create_outcome_table()
+{
+    // The 8 lines of a 3x3 board, as 9-bit masks. Not bitboard::is_three_in_a_row(), since its table lives in another
+    // translation unit, which may not be initialized yet when this one's static variables are:
+
+    const unsigned int lines[8] = {7, 56, 448, 73, 146, 292, 273, 84};
+
+    vector<char> table(1 << 18, 0);
+
+    for (unsigned int code = 0; code < (1u << 18); code++)
+    {
+        unsigned int comp = bitboard::get_comp_pieces(code);
+        unsigned int user = bitboard::get_user_pieces(code);
+
+        if (comp & user) // both sides on the same square, can't happen.
+        {
+            continue;
+        }
+
+        bool comp_has_line = false;
+        bool user_has_line = false;
+
+        for (unsigned int line: lines)
+        {
+            comp_has_line = comp_has_line || (comp & line) == line;
+            user_has_line = user_has_line || (user & line) == line;
+        }
+
+        if (comp_has_line)
+        {
+            table[code] = 1;
+        }
+
+        else if (user_has_line)
+        {
+            table[code] = 2;
+        }
+
+        else if ((comp | user) == 511)
+        {
+            table[code] = 3;
+        }
+    }
+
+    return table;
+}
+
+inline vector<short> ultimate_engine::create_score_table()
+{
+    // The 8 lines of a 3x3 board, as 9-bit masks:
+
+    const unsigned int lines[8] = {7, 56, 448, 73, 146, 292, 273, 84};
+
+    vector<short> table(1 << 18, 0);
+
+    for (unsigned int code = 0; code < (1u << 18); code++)
+    {
+        unsigned int comp = bitboard::get_comp_pieces(code);
+        unsigned int user = bitboard::get_user_pieces(code);
+
+        if (comp & user)
+        {
+            continue;
+        }
+
+        int score = 0;
+
+        for (unsigned int line: lines)
+        {
+            int comp_count = bitboard::count_pieces(comp & line);
+            int user_count = bitboard::count_pieces(user & line);
+
+            // Only lines that one side could still finish count for anything:
+
+            if (user_count == 0)
+            {
+                score += (comp_count == 2) ? 6 : comp_count;
+            }
+
+            if (comp_count == 0)
+            {
+                score -= (user_count == 2) ? 6 : user_count;
+            }
+        }
+
+        table[code] = score;
+    }
+
+    return table;
+}
+
+// PRIVATE STATIC METHODS:
+
+inline int ultimate_engine::negamax(const ultimate_state& state, int depth, int alpha, int beta, int ply,
+                             vector<table_entry>& table, long long& nodes, const search_budget& budget,
+                             bool& out_of_budget)
+{
+    nodes ++;
+
+    if ((nodes & 1023) == 0 &&
+        (chrono::steady_clock::now() >= budget.deadline || (budget.max_nodes != 0 && nodes >= budget.max_nodes)))
+    {
+        out_of_budget = true;
+    }
+
+    if (out_of_budget)
+    {
+        return 0;
+    }
+
+    int sign = state.comp_to_move ? 1 : -1; // turns the computer's point of view into the side to move's.
+
+    int outcome = get_outcome(state);
+
+    if (outcome == 1 || outcome == 2)
+    {
+        // Whoever just moved won, so the side to move lost (sooner is worse for them):
+
+        return -(win_score - ply);
+    }
+
+    if (outcome == 3)
+    {
+        return 0;
+    }
+
+    if (depth == 0)
+    {
+        return sign * evaluate(state);
+    }
+
+    // Look in the transposition table:
+
+    uint64_t key = hash(state);
+    table_entry& entry = table[key & (table.size() - 1)];
+    int table_move = -1;
+
+    if (entry.key == key)
+    {
+        table_move = entry.best_move;
+
+        if (entry.depth >= depth)
+        {
+            if (entry.bound == 0 ||
+                (entry.bound == 1 && entry.score >= beta) ||
+                (entry.bound == 2 && entry.score <= alpha))
+            {
+                return entry.score;
+            }
+        }
+    }
+
+    int moves[81];
+    int count = generate_moves(state, moves);
+
+    // Try the table's best move first, since it's usually still the best:
+
+    for (int i = 1; i < count && table_move != -1; i++)
+    {
+        if (moves[i] == table_move)
+        {
+            moves[i] = moves[0];
+            moves[0] = table_move;
+            break;
+        }
+    }
+
+    int original_alpha = alpha;
+    int best_score = -win_score - 1;
+    int best_move = moves[0];
+
+    for (int i = 0; i < count; i++)
+    {
+        int score = -negamax(apply_move(state, moves[i]), depth - 1, -beta, -alpha, ply + 1, table, nodes, budget,
+                             out_of_budget);
+
+        if (out_of_budget)
+        {
+            return 0;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_move = moves[i];
+        }
+
+        if (score > alpha)
+        {
+            alpha = score;
+        }
+
+        if (alpha >= beta)
+        {
+            break;
+        }
+    }
+
+    // Save the result (always replacing what was there):
+
+    entry.key = key;
+    entry.score = best_score;
+    entry.depth = depth;
+    entry.best_move = best_move;
+    entry.bound = (best_score <= original_alpha) ? 2 : ((best_score >= beta) ? 1 : 0);
+
+    return best_score;
+}
@@ -0,0 +1,133 @@
+/* A "worker_pool" is a fixed set of threads that run tasks handed to them, in the order they were submitted.
+
+    - Anything that wants to run on another thread (engine searches, etc.) submits a task here instead of
+      creating its own thread, so the number of threads stays the same no matter how many searches are going on.
+    - worker_pool::shared() is the pool everyone uses unless they were given a different one.
+ */
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+class worker_pool
+{
+public:
+    // Constructor & destructor:
+    worker_pool(int number_of_threadsP); // starts number_of_threadsP threads (at least 1).
+    ~worker_pool(); // lets the threads finish every task already submitted, then joins them.
+
+    // Getters:
+    int get_number_of_threads() const;
+
+    // Public methods:
+    void submit(function<void()> task); // task will be run on one of the pool's threads as soon as one is free.
+
+    // Public static methods:
+    static worker_pool& shared(); // returns the pool shared by the whole program (one thread per core).
+
+private:
+    vector <thread> workers; // stores the pool's threads.
+    queue <function<void()>> tasks; // stores the tasks that haven't been picked up by a thread yet.
+    mutex tasks_mutex; // guards tasks and shutting_down.
+    condition_variable tasks_changed; // signalled when a task is added, or the pool is shutting down.
+    bool shutting_down; // stores true once the destructor has been called.
+
+    // Private methods:
+    void work(); // what each thread runs: take a task, run it, repeat.
+};
+
+// CONSTRUCTOR & DESTRUCTOR:
+
+inline worker_pool::worker_pool(int number_of_threadsP)
+{
+    shutting_down = false;
+
+    if (number_of_threadsP < 1)
+    {
+        number_of_threadsP = 1;
+    }
+
+    for (int i = 0; i < number_of_threadsP; i++)
+    {
+        workers.push_back(thread(&worker_pool::work, this));
+    }
+}
+
+inline worker_pool::~worker_pool()
+{
+    {
+        lock_guard<mutex> lock(tasks_mutex);
+
+        shutting_down = true;
+    }
+
+    tasks_changed.notify_all();
+
+    for (thread& worker: workers)
+    {
+        worker.join();
+    }
+}
+
+// GETTERS:
+
+inline int worker_pool::get_number_of_threads() const
+{
+    return workers.size();
+}
+
+// PUBLIC METHODS:
+
+inline void worker_pool::submit(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(tasks_mutex);
+
+        tasks.push(move(task));
+    }
+
+    tasks_changed.notify_one();
+}
+
+// PUBLIC STATIC METHODS:
+
+inline worker_pool& worker_pool::shared()
+{
+    static worker_pool pool(thread::hardware_concurrency()); // created the first time anyone asks for it.
+
+    return pool;
+}
+
+// PRIVATE METHODS:
+
+inline void worker_pool::work()
+{
+    while (true)
+    {
+        function<void()> task;
+
+        {
+            unique_lock<mutex> lock(tasks_mutex);
+
+            tasks_changed.wait(lock, [this] { return shutting_down || !tasks.empty(); });
+
+            if (tasks.empty()) // so shutting_down is true, and there's nothing left to do.
+            {
+                return;
+            }
+
+            task = move(tasks.front());
+
+            tasks.pop();
+        }
+
+        task();
+    }
+}